@@ -0,0 +1,456 @@
+/**
+ ******************************************************************************
+ * @file	animation.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for a keyframe animation sequencer
+ *			- Interprets byte scripts from flash, RAM or the 24AA16 EEPROM
+ *			- Set, fade, wait, loop and wait for event
+ *			- Non-blocking, ANIMATION_Process advances the script from millis()
+ *			- Drives any output through ANIMATION_Output_TypeDef
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <assert/assert.h>
+#include <MILLIS_COUNT/millis_count.h>
+#ifdef ANIMATION_USE_EEPROM_24AA16
+#include <EEPROM_24AA16/EEPROM_24AA16.h>
+#endif
+#include "animation.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define STATE_STOPPED		0x00
+#define STATE_RUNNING		0x01
+#define STATE_WAITING		0x02
+#define STATE_FADING		0x03
+#define STATE_WAIT_EVENT	0x04
+
+// Time comparison that survives the wrap of the millisecond counter
+#define TIME_REACHED(NOW, TIME)	((int32_t)((NOW) - (TIME)) >= 0)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+	uint16_t start;
+	uint8_t remaining;
+} Loop_TypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+const ANIMATION_Output_TypeDef* _animationOutput;
+ANIMATION_Source_TypeDef _animationSource;
+uint16_t _animationPc;
+uint8_t _animationState;
+
+// Start time of the current instruction, advanced by the length of each delay so timing does not drift
+uint32_t _animationTime;
+uint32_t _animationLastFrame;
+uint16_t _animationDuration;
+uint8_t _animationEventMask;
+volatile uint8_t _animationEvents;
+
+Loop_TypeDef _animationLoops[ANIMATION_LOOP_DEPTH];
+uint8_t _animationLoopDepth;
+
+uint8_t _animationFirst;
+uint8_t _animationCount;
+uint8_t _animationDirty;
+
+rgb16 _animationPixels[ANIMATION_MAX_PIXELS];
+rgb16 _animationFadeStart[ANIMATION_MAX_PIXELS];
+rgb16 _animationFadeTarget;
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t readByte();
+static uint16_t readWord();
+static void execute();
+static void setSelected(const rgb16* Color);
+static void startFade(const rgb16* Target, uint16_t Duration);
+static void renderFade(uint16_t Elapsed);
+static void show();
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes the sequencer and MILLIS_COUNT if it is not already initialized
+ * @param	None
+ * @retval	None
+ */
+void ANIMATION_Init()
+{
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	
+	_animationState = STATE_STOPPED;
+}
+
+/**
+ * @brief	Starts a script from the beginning. All pixels start black and selected.
+ * @param	Output: The output to show the animation on
+ * @param	Source: Where the script is stored
+ * @param	Address: Address of the first instruction, for flash and RAM
+ *			this is the pointer to the script
+ * @retval	None
+ */
+void ANIMATION_Start(const ANIMATION_Output_TypeDef* Output, ANIMATION_Source_TypeDef Source, uint16_t Address)
+{
+	assert_param(Output != 0 && Output->setPixel != 0);
+	assert_param(IS_ANIMATION_SOURCE(Source));
+	
+	_animationOutput = Output;
+	_animationSource = Source;
+	_animationPc = Address;
+	_animationLoopDepth = 0;
+	_animationFirst = 0;
+	_animationCount = Output->numOfPixels;
+	if (_animationCount > ANIMATION_MAX_PIXELS)
+		_animationCount = ANIMATION_MAX_PIXELS;
+	
+	for (uint8_t i = 0; i < ANIMATION_MAX_PIXELS; i++)
+	{
+		_animationPixels[i].red = 0;
+		_animationPixels[i].green = 0;
+		_animationPixels[i].blue = 0;
+	}
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_animationEvents = 0;
+	}
+	_animationTime = millis();
+	_animationState = STATE_RUNNING;
+}
+
+/**
+ * @brief	Stops the animation, the output keeps the last shown colors
+ * @param	None
+ * @retval	None
+ */
+void ANIMATION_Stop()
+{
+	_animationState = STATE_STOPPED;
+}
+
+/**
+ * @brief	Checks if an animation is running
+ * @param	None
+ * @retval	1 if running, 0 if stopped or the script has ended
+ */
+uint8_t ANIMATION_IsRunning()
+{
+	return (_animationState != STATE_STOPPED);
+}
+
+/**
+ * @brief	Sets event bits for ANIMATION_WAIT_EVENT. The bits that a waiting
+ *			instruction matches are cleared when it continues.
+ * @param	Events: The event bits to set
+ * @retval	None
+ * @note	Can be called from an ISR
+ */
+void ANIMATION_SetEvent(uint8_t Events)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_animationEvents |= Events;
+	}
+}
+
+/**
+ * @brief	Advances the animation to the current time
+ * @param	None
+ * @retval	None
+ * @note	Call this from the main loop. A fade is shown at most once every
+ *			ANIMATION_FRAME_TIME ms.
+ */
+void ANIMATION_Process()
+{
+	uint32_t now = millis();
+	uint32_t elapsed = now - _animationTime;
+	
+	switch (_animationState)
+	{
+		case STATE_WAITING:
+			if (elapsed < _animationDuration) return;
+			_animationTime += _animationDuration;
+			_animationState = STATE_RUNNING;
+			break;
+		
+		case STATE_FADING:
+			if (elapsed < _animationDuration)
+			{
+				if (TIME_REACHED(now, _animationLastFrame + ANIMATION_FRAME_TIME))
+				{
+					_animationLastFrame = now;
+					renderFade(elapsed);
+					show();
+				}
+				return;
+			}
+			setSelected(&_animationFadeTarget);
+			_animationTime += _animationDuration;
+			_animationState = STATE_RUNNING;
+			break;
+		
+		case STATE_WAIT_EVENT:
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				if (_animationEvents & _animationEventMask)
+				{
+					_animationEvents &= ~_animationEventMask;
+					_animationState = STATE_RUNNING;
+				}
+			}
+			if (_animationState != STATE_RUNNING) return;
+			_animationTime = now;
+			break;
+		
+		case STATE_RUNNING:
+			break;
+		
+		default:
+			return;
+	}
+	
+	for (uint8_t i = 0; i < ANIMATION_MAX_STEPS && _animationState == STATE_RUNNING; i++)
+		execute();
+	
+	show();
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Reads the next byte of the script
+ * @param	None
+ * @retval	The byte
+ */
+static uint8_t readByte()
+{
+	uint16_t address = _animationPc++;
+	switch (_animationSource)
+	{
+		case ANIMATION_SOURCE_FLASH:
+			return pgm_read_byte((const uint8_t*)address);
+
+#ifdef ANIMATION_USE_EEPROM_24AA16
+		case ANIMATION_SOURCE_EEPROM:
+			return eeprom24aa16readFromAddress(address);
+#endif
+
+		case ANIMATION_SOURCE_RAM:
+			return *(const uint8_t*)address;
+		
+		default:
+			return ANIMATION_OP_END;
+	}
+}
+
+/**
+ * @brief	Reads the next two bytes of the script, MSB first
+ * @param	None
+ * @retval	The word
+ */
+static uint16_t readWord()
+{
+	uint16_t word = (uint16_t)readByte() << 8;
+	return word | readByte();
+}
+
+/**
+ * @brief	Runs the next instruction
+ * @param	None
+ * @retval	None
+ */
+static void execute()
+{
+	rgb16 color;
+	uint16_t hue;
+	uint8_t saturation, brightness, step;
+	uint8_t opcode = readByte();
+	
+	switch (opcode)
+	{
+		case ANIMATION_OP_SET_RGB:
+		case ANIMATION_OP_FADE_RGB:
+			// 8-bit to 16-bit by repeating the byte
+			color.red = readByte() * 0x101;
+			color.green = readByte() * 0x101;
+			color.blue = readByte() * 0x101;
+			if (opcode == ANIMATION_OP_SET_RGB)
+				setSelected(&color);
+			else
+				startFade(&color, readWord());
+			break;
+		
+		case ANIMATION_OP_SET_HSB:
+		case ANIMATION_OP_FADE_HSB:
+			hue = readWord();
+			saturation = readByte();
+			brightness = readByte();
+			HSBtoRGB16(hue, saturation, brightness, &color.red, &color.green, &color.blue);
+			if (opcode == ANIMATION_OP_SET_HSB)
+				setSelected(&color);
+			else
+				startFade(&color, readWord());
+			break;
+		
+		case ANIMATION_OP_WAIT:
+			_animationDuration = readWord();
+			_animationState = STATE_WAITING;
+			break;
+		
+		case ANIMATION_OP_LOOP:
+			if (_animationLoopDepth == ANIMATION_LOOP_DEPTH)
+			{
+				_animationState = STATE_STOPPED;
+				break;
+			}
+			_animationLoops[_animationLoopDepth].remaining = readByte();
+			_animationLoops[_animationLoopDepth].start = _animationPc;
+			_animationLoopDepth++;
+			break;
+		
+		case ANIMATION_OP_NEXT:
+			if (_animationLoopDepth == 0)
+			{
+				_animationState = STATE_STOPPED;
+				break;
+			}
+			else
+			{
+				Loop_TypeDef* loop = &_animationLoops[_animationLoopDepth - 1];
+				// A count of 0 is never decreased and loops forever
+				if (loop->remaining == 0 || --loop->remaining != 0)
+					_animationPc = loop->start;
+				else
+					_animationLoopDepth--;
+			}
+			break;
+		
+		case ANIMATION_OP_WAIT_EVENT:
+			_animationEventMask = readByte();
+			_animationState = STATE_WAIT_EVENT;
+			break;
+		
+		case ANIMATION_OP_SELECT:
+		{
+			uint8_t numOfPixels = _animationOutput->numOfPixels;
+			if (numOfPixels > ANIMATION_MAX_PIXELS)
+				numOfPixels = ANIMATION_MAX_PIXELS;
+			
+			_animationFirst = readByte();
+			_animationCount = readByte();
+			if (_animationFirst > numOfPixels)
+				_animationFirst = numOfPixels;
+			if (_animationCount == 0 || _animationCount > numOfPixels - _animationFirst)
+				_animationCount = numOfPixels - _animationFirst;
+			break;
+		}
+		
+		case ANIMATION_OP_RAINBOW:
+			hue = readWord();
+			step = readByte();
+			saturation = readByte();
+			brightness = readByte();
+			for (uint8_t i = _animationFirst; i < _animationFirst + _animationCount; i++)
+			{
+				hue %= 360;
+				HSBtoRGB16(hue, saturation, brightness, &color.red, &color.green, &color.blue);
+				_animationPixels[i] = color;
+				hue += step;
+			}
+			_animationDirty = 1;
+			break;
+		
+		case ANIMATION_OP_ROTATE:
+			if (_animationCount > 1)
+			{
+				uint8_t last = _animationFirst + _animationCount - 1;
+				color = _animationPixels[last];
+				for (uint8_t i = last; i > _animationFirst; i--)
+					_animationPixels[i] = _animationPixels[i - 1];
+				_animationPixels[_animationFirst] = color;
+				_animationDirty = 1;
+			}
+			break;
+		
+		default:
+			// ANIMATION_OP_END or an unknown instruction
+			_animationState = STATE_STOPPED;
+			break;
+	}
+}
+
+/**
+ * @brief	Sets all selected pixels to a color
+ * @param	Color: The color to set
+ * @retval	None
+ */
+static void setSelected(const rgb16* Color)
+{
+	for (uint8_t i = _animationFirst; i < _animationFirst + _animationCount; i++)
+		_animationPixels[i] = *Color;
+	_animationDirty = 1;
+}
+
+/**
+ * @brief	Starts a fade of the selected pixels from their current colors
+ * @param	Target: The color to fade to
+ * @param	Duration: Time in ms for the fade
+ * @retval	None
+ */
+static void startFade(const rgb16* Target, uint16_t Duration)
+{
+	for (uint8_t i = _animationFirst; i < _animationFirst + _animationCount; i++)
+		_animationFadeStart[i] = _animationPixels[i];
+	_animationFadeTarget = *Target;
+	_animationDuration = Duration;
+	_animationLastFrame = _animationTime;
+	_animationState = STATE_FADING;
+}
+
+/**
+ * @brief	Interpolates the selected pixels linearly in RGB
+ * @param	Elapsed: Time in ms since the fade started, less than the duration
+ * @retval	None
+ */
+static void renderFade(uint16_t Elapsed)
+{
+	// Q15, the largest change of 0xFFFF * 0x8000 still fits in an int32_t
+	uint16_t progress = ((uint32_t)Elapsed << 15) / _animationDuration;
+	
+	for (uint8_t i = _animationFirst; i < _animationFirst + _animationCount; i++)
+	{
+		const rgb16* start = &_animationFadeStart[i];
+		rgb16* pixel = &_animationPixels[i];
+		pixel->red = start->red + (((int32_t)_animationFadeTarget.red - start->red) * progress >> 15);
+		pixel->green = start->green + (((int32_t)_animationFadeTarget.green - start->green) * progress >> 15);
+		pixel->blue = start->blue + (((int32_t)_animationFadeTarget.blue - start->blue) * progress >> 15);
+	}
+	_animationDirty = 1;
+}
+
+/**
+ * @brief	Writes the pixels to the output if anything has changed
+ * @param	None
+ * @retval	None
+ */
+static void show()
+{
+	if (!_animationDirty) return;
+	_animationDirty = 0;
+	
+	uint8_t numOfPixels = _animationOutput->numOfPixels;
+	if (numOfPixels > ANIMATION_MAX_PIXELS)
+		numOfPixels = ANIMATION_MAX_PIXELS;
+	
+	for (uint8_t i = 0; i < numOfPixels; i++)
+		_animationOutput->setPixel(i, &_animationPixels[i]);
+	if (_animationOutput->show)
+		_animationOutput->show();
+}
+
+/* Interrupt Service Routines ------------------------------------------------*/
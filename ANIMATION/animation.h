@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file	animation.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains typedefs, script macros and function prototypes for a
+ *			keyframe animation sequencer
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <COLOR/color.h>
+
+/* Defines -------------------------------------------------------------------*/
+/*
+ * An animation is a script of byte instructions stored in flash, RAM or in
+ * the 24AA16 EEPROM (define ANIMATION_USE_EEPROM_24AA16). Instructions work on
+ * the selected pixels, all pixels are selected when the script starts.
+ * Multi-byte arguments are stored MSB first. Example:
+ *
+ *	const uint8_t pulse[] PROGMEM = {
+ *		ANIMATION_LOOP(0),
+ *		ANIMATION_FADE_HSB(240, 100, 100, 500),
+ *		ANIMATION_FADE_HSB(240, 100, 10, 500),
+ *		ANIMATION_NEXT(),
+ *		ANIMATION_END()
+ *	};
+ *	ANIMATION_Start(&myOutput, ANIMATION_SOURCE_FLASH, (uint16_t)pulse);
+ */
+#define ANIMATION_OP_END			0x00	/* Stop the animation */
+#define ANIMATION_OP_SET_RGB		0x01	/* red, green, blue (8-bit) */
+#define ANIMATION_OP_SET_HSB		0x02	/* hue (16-bit), saturation, brightness */
+#define ANIMATION_OP_FADE_RGB		0x03	/* red, green, blue (8-bit), time in ms (16-bit) */
+#define ANIMATION_OP_FADE_HSB		0x04	/* hue (16-bit), saturation, brightness, time in ms (16-bit) */
+#define ANIMATION_OP_WAIT			0x05	/* time in ms (16-bit) */
+#define ANIMATION_OP_LOOP			0x06	/* count, 0 loops forever */
+#define ANIMATION_OP_NEXT			0x07	/* End of the innermost loop */
+#define ANIMATION_OP_WAIT_EVENT		0x08	/* event mask */
+#define ANIMATION_OP_SELECT			0x09	/* first pixel, count, 0 selects the rest of the pixels */
+#define ANIMATION_OP_RAINBOW		0x0A	/* hue (16-bit), hue step per pixel, saturation, brightness */
+#define ANIMATION_OP_ROTATE			0x0B	/* Move the selected pixels one step up, the last one wraps around */
+
+#define ANIMATION_U16(VALUE)		(uint8_t)((VALUE) >> 8), (uint8_t)((VALUE) & 0xFF)
+
+#define ANIMATION_END()							ANIMATION_OP_END
+#define ANIMATION_SET_RGB(R, G, B)				ANIMATION_OP_SET_RGB, (R), (G), (B)
+#define ANIMATION_SET_HSB(H, S, B)				ANIMATION_OP_SET_HSB, ANIMATION_U16(H), (S), (B)
+#define ANIMATION_FADE_RGB(R, G, B, MS)			ANIMATION_OP_FADE_RGB, (R), (G), (B), ANIMATION_U16(MS)
+#define ANIMATION_FADE_HSB(H, S, B, MS)			ANIMATION_OP_FADE_HSB, ANIMATION_U16(H), (S), (B), ANIMATION_U16(MS)
+#define ANIMATION_WAIT(MS)						ANIMATION_OP_WAIT, ANIMATION_U16(MS)
+#define ANIMATION_LOOP(COUNT)					ANIMATION_OP_LOOP, (COUNT)
+#define ANIMATION_NEXT()						ANIMATION_OP_NEXT
+#define ANIMATION_WAIT_EVENT(MASK)				ANIMATION_OP_WAIT_EVENT, (MASK)
+#define ANIMATION_SELECT(FIRST, COUNT)			ANIMATION_OP_SELECT, (FIRST), (COUNT)
+#define ANIMATION_RAINBOW(H, STEP, S, B)		ANIMATION_OP_RAINBOW, ANIMATION_U16(H), (STEP), (S), (B)
+#define ANIMATION_ROTATE()						ANIMATION_OP_ROTATE
+
+// Pixels that are kept in RAM, 12 bytes each
+#ifndef ANIMATION_MAX_PIXELS
+#define ANIMATION_MAX_PIXELS		16
+#endif
+
+// Nesting depth for ANIMATION_LOOP
+#ifndef ANIMATION_LOOP_DEPTH
+#define ANIMATION_LOOP_DEPTH		4
+#endif
+
+// Minimum time in ms between two frames of a fade
+#ifndef ANIMATION_FRAME_TIME
+#define ANIMATION_FRAME_TIME		20
+#endif
+
+// Instructions without a delay that are run in one call to ANIMATION_Process
+#ifndef ANIMATION_MAX_STEPS
+#define ANIMATION_MAX_STEPS			16
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief	Where the script is stored
+ */
+typedef enum
+{
+	ANIMATION_SOURCE_RAM =		0x00,
+	ANIMATION_SOURCE_FLASH =	0x01,
+	ANIMATION_SOURCE_EEPROM =	0x02
+} ANIMATION_Source_TypeDef;
+#define IS_ANIMATION_SOURCE(SOURCE) ((SOURCE) <= ANIMATION_SOURCE_EEPROM)
+
+/**
+ * @brief	Typedef for a pointer to a function that sets the color of one pixel
+ *			with 16-bit values. The output should not change until show is called.
+ */
+typedef void (*ANIMATION_SetPixel_TypeDef)(uint8_t Pixel, const rgb16* Color);
+
+/**
+ * @brief	Typedef for a pointer to a function that shows the pixels set since
+ *			the last call
+ */
+typedef void (*ANIMATION_Show_TypeDef)(void);
+
+/**
+ * @brief	The output the animation is shown on, see animation_outputs.h for
+ *			outputs using the LED drivers in this library
+ */
+typedef struct
+{
+	uint8_t numOfPixels;				/** Number of pixels on the output */
+	ANIMATION_SetPixel_TypeDef setPixel;	/** Sets the color of one pixel */
+	ANIMATION_Show_TypeDef show;			/** Shows the new colors, can be 0 */
+} ANIMATION_Output_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void ANIMATION_Init();
+void ANIMATION_Start(const ANIMATION_Output_TypeDef* Output, ANIMATION_Source_TypeDef Source, uint16_t Address);
+void ANIMATION_Stop();
+uint8_t ANIMATION_IsRunning();
+void ANIMATION_SetEvent(uint8_t Events);
+void ANIMATION_Process();
+
+#endif /* ANIMATION_H_ */
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @file	animation_outputs.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains ANIMATION outputs for the LED drivers in this library
+ *			- LED_STRIP
+ *			- PCA9633
+ *			- PCA9685
+ *			- TLC5947
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#ifdef ANIMATION_USE_LED_STRIP
+#include <LED_STRIP/led_strip.h>
+#endif
+#ifdef ANIMATION_USE_PCA9633
+#include <PCA9633/PCA9633.h>
+#endif
+#ifdef ANIMATION_USE_PCA9685
+#include <PCA9685/pca9685.h>
+#endif
+#ifdef ANIMATION_USE_TLC5947
+#include <TLC5947/tlc5947.h>
+#endif
+#include "animation_outputs.h"
+
+/* LED_STRIP -----------------------------------------------------------------*/
+#ifdef ANIMATION_USE_LED_STRIP
+rgb16 _animationLedStripColor;
+
+static void ledStripSetPixel(uint8_t Pixel, const rgb16* Color)
+{
+	_animationLedStripColor = *Color;
+}
+
+static void ledStripShow()
+{
+#ifdef LED_STRIP_16BIT
+	setAndShowLedStripRGB16(_animationLedStripColor.red, _animationLedStripColor.green, _animationLedStripColor.blue);
+#else
+	setAndShowLedStripRGB(_animationLedStripColor.red >> 8, _animationLedStripColor.green >> 8,
+						_animationLedStripColor.blue >> 8);
+#endif
+}
+
+const ANIMATION_Output_TypeDef ANIMATION_OutputLedStrip = {1, ledStripSetPixel, ledStripShow};
+#endif
+
+/* PCA9633 -------------------------------------------------------------------*/
+#ifdef ANIMATION_USE_PCA9633
+rgb8 _animationPca9633Color;
+
+static void pca9633SetPixel(uint8_t Pixel, const rgb16* Color)
+{
+	_animationPca9633Color.red = Color->red >> 8;
+	_animationPca9633Color.green = Color->green >> 8;
+	_animationPca9633Color.blue = Color->blue >> 8;
+}
+
+static void pca9633Show()
+{
+	// Same as LED_STRIP_PCA9633, the fourth output is kept at 255
+	pca9633setAllOutputs(_animationPca9633Color.red, _animationPca9633Color.green, _animationPca9633Color.blue, 255);
+}
+
+const ANIMATION_Output_TypeDef ANIMATION_OutputPca9633 = {1, pca9633SetPixel, pca9633Show};
+#endif
+
+/* PCA9685 -------------------------------------------------------------------*/
+#ifdef ANIMATION_USE_PCA9685
+#define ANIMATION_PCA9685_PIXELS	5
+
+uint16_t _animationPca9685Values[ANIMATION_PCA9685_PIXELS * 3];
+
+static void pca9685SetPixel(uint8_t Pixel, const rgb16* Color)
+{
+	uint16_t* values = &_animationPca9685Values[Pixel * 3];
+	values[0] = Color->red >> 4;
+	values[1] = Color->green >> 4;
+	values[2] = Color->blue >> 4;
+}
+
+// All 15 outputs in one transaction
+static void pca9685Show()
+{
+	PCA9685_SetOutputs(ANIMATION_PCA9685_ADDRESS, 0, ANIMATION_PCA9685_PIXELS * 3, _animationPca9685Values);
+}
+
+const ANIMATION_Output_TypeDef ANIMATION_OutputPca9685 = {ANIMATION_PCA9685_PIXELS, pca9685SetPixel, pca9685Show};
+#endif
+
+/* TLC5947 -------------------------------------------------------------------*/
+#ifdef ANIMATION_USE_TLC5947
+static void tlc5947SetPixel(uint8_t Pixel, const rgb16* Color)
+{
+	tlc5947setPixelRGB(Pixel % NUM_OF_PIXELS, Pixel / NUM_OF_PIXELS, Color->red >> 4, Color->green >> 4, Color->blue >> 4);
+}
+
+const ANIMATION_Output_TypeDef ANIMATION_OutputTlc5947 = {TOTAL_OF_PIXELS, tlc5947SetPixel, tlc5947update};
+#endif
@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @file	animation_outputs.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains ANIMATION outputs for the LED drivers in this library
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef ANIMATION_OUTPUTS_H_
+#define ANIMATION_OUTPUTS_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "animation.h"
+
+/* Defines -------------------------------------------------------------------*/
+/*
+ * Only the outputs that are enabled here are compiled so a project does not
+ * need the drivers it does not use:
+ *	ANIMATION_USE_LED_STRIP:	One pixel on LED_STRIP, 16-bit with LED_STRIP_DITHER
+ *								or LED_STRIP_TIMER1
+ *	ANIMATION_USE_PCA9633:		One pixel on PWM0-PWM2 of the PCA9633
+ *	ANIMATION_USE_PCA9685:		Five pixels on LED0-LED14 of the PCA9685 at
+ *								ANIMATION_PCA9685_ADDRESS
+ *	ANIMATION_USE_TLC5947:		TOTAL_OF_PIXELS pixels on the TLC5947 modules
+ *
+ * LED_STRIP uses TIMER0 and TIMER1 and ANIMATION needs MILLIS_COUNT, which is
+ * on TIMER1 unless MILLIS_COUNT_TICKLESS moves it to TIMER2. The LED_STRIP
+ * output therefore needs MILLIS_COUNT_TICKLESS defined for the whole project.
+ */
+#if defined(ANIMATION_USE_LED_STRIP) && !defined(MILLIS_COUNT_TICKLESS)
+#error "ANIMATION_USE_LED_STRIP needs MILLIS_COUNT_TICKLESS, LED_STRIP and MILLIS_COUNT both use TIMER1"
+#endif
+
+#if defined(ANIMATION_USE_PCA9685) && !defined(ANIMATION_PCA9685_ADDRESS)
+#define ANIMATION_PCA9685_ADDRESS	0x40
+#endif
+
+/* Outputs -------------------------------------------------------------------*/
+#ifdef ANIMATION_USE_LED_STRIP
+extern const ANIMATION_Output_TypeDef ANIMATION_OutputLedStrip;
+#endif
+
+#ifdef ANIMATION_USE_PCA9633
+extern const ANIMATION_Output_TypeDef ANIMATION_OutputPca9633;
+#endif
+
+#ifdef ANIMATION_USE_PCA9685
+extern const ANIMATION_Output_TypeDef ANIMATION_OutputPca9685;
+#endif
+
+#ifdef ANIMATION_USE_TLC5947
+extern const ANIMATION_Output_TypeDef ANIMATION_OutputTlc5947;
+#endif
+
+#endif /* ANIMATION_OUTPUTS_H_ */
@@ -0,0 +1,179 @@
+/**
+ ******************************************************************************
+ * @file	color.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for HSB/RGB conversion with integer math
+ *			- HSB to RGB is calculated exactly in integers and scaled to the
+ *			  output depth with a fixed-point multiply
+ *			- RGB to HSB is the same algorithm for all depths, generated by a
+ *			  macro with the smallest integer type that fits the calculation
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "color.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define FULL_8BIT	0xFF
+#define FULL_12BIT	0x0FFF
+#define FULL_16BIT	0xFFFF
+
+/*
+ * Each RGB channel is one of
+ *		brightness * (1 - saturation * k / 60)
+ * with k = 0, 60, f or 60 - f where f is the position in the 60 degree
+ * sector. With saturation and brightness in percent this is
+ *		FULL * n / 600000,	n = bright * (6000 - sat * k)
+ * n is at most 600000 so it is split in (n >> 10) and (n & 1023) and each
+ * part is multiplied with FULL / 600000 in Q15, rounded up so full scale
+ * is reached. The result is within 0.02 LSB of the exact value.
+ */
+#define N_FULL_SCALE		600000ULL
+#define SCALE_HIGH(FULL)	((uint32_t)(((FULL) * 1024ULL * 32768ULL + N_FULL_SCALE - 1) / N_FULL_SCALE))
+#define SCALE_LOW(FULL)		((uint32_t)(((FULL) * 32768ULL + N_FULL_SCALE - 1) / N_FULL_SCALE))
+#define SCALE_N(N, FULL)	((((N) >> 10) * SCALE_HIGH(FULL) + ((N) & 1023) * SCALE_LOW(FULL)) >> 15)
+
+/* Private functions ---------------------------------------------------------*/
+static void hsbToN(uint16_t hue, uint8_t sat, uint8_t bright, uint32_t *rgb);
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Converts HSB to RGB
+ * @param	hue: Hue in degrees, values above 359 wrap around
+ * @param	sat: Saturation, 0-100
+ * @param	bright: Brightness, 0-100
+ * @param	red, green, blue: Pointers to where the result is stored
+ * @retval	None
+ */
+#define DEFINE_HSB_TO_RGB(NAME, TYPE, FULL)									\
+void NAME(uint16_t hue, uint8_t sat, uint8_t bright, TYPE *red, TYPE *green, TYPE *blue)	\
+{																			\
+	uint32_t rgb[3];														\
+	hsbToN(hue, sat, bright, rgb);											\
+	*red = SCALE_N(rgb[0], FULL);											\
+	*green = SCALE_N(rgb[1], FULL);											\
+	*blue = SCALE_N(rgb[2], FULL);											\
+}
+
+DEFINE_HSB_TO_RGB(HSBtoRGB8, uint8_t, FULL_8BIT)
+DEFINE_HSB_TO_RGB(HSBtoRGB12, uint16_t, FULL_12BIT)
+DEFINE_HSB_TO_RGB(HSBtoRGB16, uint16_t, FULL_16BIT)
+
+/**
+ * @brief	Converts RGB to HSB
+ * @param	red, green, blue: The color
+ * @param	hue: Hue in degrees, 0-359. 0xFFFF if the color is black
+ * @param	sat: Saturation, 0-100
+ * @param	bright: Brightness, 0-100. 0xFF if the color is black
+ * @retval	None
+ * @note	WIDE must hold the value times 100 and times 60
+ */
+#define DEFINE_RGB_TO_HSB(NAME, TYPE, WIDE, FULL)							\
+void NAME(TYPE red, TYPE green, TYPE blue, uint16_t *hue, uint8_t *sat, uint8_t *bright)	\
+{																			\
+	TYPE max = red;															\
+	if (green > max) max = green;											\
+	if (blue > max) max = blue;												\
+																			\
+	TYPE min = red;															\
+	if (green < min) min = green;											\
+	if (blue < min) min = blue;												\
+																			\
+	if (max == 0)															\
+	{																		\
+		/* Black, hue and brightness are undefined */						\
+		*hue = -1;															\
+		*sat = 0;															\
+		*bright = -1;														\
+		return;																\
+	}																		\
+																			\
+	TYPE delta = max - min;													\
+	*bright = (WIDE)max * 100 / (FULL);										\
+	*sat = (WIDE)delta * 100 / max;											\
+																			\
+	/* Hue is floor(base + 60 * diff / delta), negative wraps to 360 */		\
+	uint16_t base;															\
+	TYPE plus, minus;														\
+	if (delta == 0)															\
+	{																		\
+		*hue = 0;															\
+		return;																\
+	}																		\
+	else if (red == max)													\
+	{																		\
+		base = 0;	plus = green;	minus = blue;							\
+	}																		\
+	else if (green == max)													\
+	{																		\
+		base = 120;	plus = blue;	minus = red;							\
+	}																		\
+	else																	\
+	{																		\
+		base = 240;	plus = red;		minus = green;							\
+	}																		\
+																			\
+	if (plus >= minus)														\
+		*hue = base + (WIDE)(plus - minus) * 60 / delta;					\
+	else																	\
+	{																		\
+		if (base == 0) base = 360;											\
+		*hue = base - ((WIDE)(minus - plus) * 60 + delta - 1) / delta;		\
+	}																		\
+}
+
+DEFINE_RGB_TO_HSB(RGB8toHSB, uint8_t, uint16_t, FULL_8BIT)
+DEFINE_RGB_TO_HSB(RGB12toHSB, uint16_t, uint32_t, FULL_12BIT)
+DEFINE_RGB_TO_HSB(RGB16toHSB, uint16_t, uint32_t, FULL_16BIT)
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Calculates n = bright * (6000 - sat * k) for each RGB channel
+ * @param	hue: Hue in degrees, values above 359 wrap around
+ * @param	sat: Saturation, 0-100
+ * @param	bright: Brightness, 0-100
+ * @param	rgb: Array of three where the result is stored, 600000 is full scale
+ * @retval	None
+ */
+static void hsbToN(uint16_t hue, uint8_t sat, uint8_t bright, uint32_t *rgb)
+{
+	if (sat > 100) sat = 100;
+	if (bright > 100) bright = 100;
+	
+	hue = hue % 360;
+	uint8_t sector = 0;
+	while (hue >= 60)
+	{
+		hue -= 60;
+		sector++;
+	}
+	
+	uint32_t v = (uint32_t)bright * 6000;
+	uint32_t p = (uint32_t)bright * (6000 - (uint16_t)sat * 60);
+	uint32_t q = (uint32_t)bright * (6000 - (uint16_t)sat * hue);
+	uint32_t t = (uint32_t)bright * (6000 - (uint16_t)sat * (60 - hue));
+	
+	switch (sector)
+	{
+	case 0:
+		rgb[0] = v; rgb[1] = t; rgb[2] = p;
+		break;
+	case 1:
+		rgb[0] = q; rgb[1] = v; rgb[2] = p;
+		break;
+	case 2:
+		rgb[0] = p; rgb[1] = v; rgb[2] = t;
+		break;
+	case 3:
+		rgb[0] = p; rgb[1] = q; rgb[2] = v;
+		break;
+	case 4:
+		rgb[0] = t; rgb[1] = p; rgb[2] = v;
+		break;
+	default:
+		rgb[0] = v; rgb[1] = p; rgb[2] = q;
+		break;
+	}
+}
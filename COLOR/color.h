@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ * @file	color.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains color types and function prototypes for HSB/RGB conversion
+ *			with 8, 12 and 16-bit RGB values
+ * @note	Hue is in degrees (0-359), saturation and brightness in percent (0-100)
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef COLOR_H_
+#define COLOR_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Typedefs ------------------------------------------------------------------*/
+typedef struct  
+{
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+} rgb8;
+
+typedef struct
+{
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint8_t alpha;
+} rgba8;
+
+typedef struct
+{
+	uint16_t red;
+	uint16_t green;
+	uint16_t blue;
+} rgb16;
+
+// 12-bit values are stored right aligned in 16 bits
+typedef rgb16 rgb12;
+
+typedef struct  
+{
+	uint16_t hue;
+	uint8_t saturation;
+	uint8_t brightness;
+} hsb;
+
+/* Function prototypes -------------------------------------------------------*/
+void HSBtoRGB8(uint16_t hue, uint8_t sat, uint8_t bright, uint8_t *red, uint8_t *green, uint8_t *blue);
+void HSBtoRGB12(uint16_t hue, uint8_t sat, uint8_t bright, uint16_t *red, uint16_t *green, uint16_t *blue);
+void HSBtoRGB16(uint16_t hue, uint8_t sat, uint8_t bright, uint16_t *red, uint16_t *green, uint16_t *blue);
+
+void RGB8toHSB(uint8_t red, uint8_t green, uint8_t blue, uint16_t *hue, uint8_t *sat, uint8_t *bright);
+void RGB12toHSB(uint16_t red, uint16_t green, uint16_t blue, uint16_t *hue, uint8_t *sat, uint8_t *bright);
+void RGB16toHSB(uint16_t red, uint16_t green, uint16_t blue, uint16_t *hue, uint8_t *sat, uint8_t *bright);
+
+#endif /* COLOR_H_ */
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file	color_host_test.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Exhaustive host test of the 8-bit integer HSB/RGB conversion in
+ *			color.c against the float code it replaced
+ *			- HSBtoRGB8 for hue 0-719, saturation 0-100, brightness 0-100
+ *			- RGB8toHSB for all 2^24 colors
+ *			Every value must be within 1 of the float result.
+ * @note	Not part of the AVR build, run it on the host from the library root:
+ *			gcc -O2 -I. COLOR/color_host_test.c COLOR/color.c -o color_test && ./color_test
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "color.h"
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	The float HSBtoRGB from COLOR_8_BIT without volatile
+ */
+static void floatHsbToRgb(uint16_t hue, uint8_t sat, uint8_t bright, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+	float saturation = (float)sat / 100.0, brightness = (float)bright / 100.0, h_i, f, p, q, t, R, G, B;
+	hue = hue % 360;
+	h_i = hue / 60;
+	f = (float)(hue) / 60.0 - h_i;
+	p = brightness * (1 - saturation);
+	q = brightness * (1 - saturation * f);
+	t = brightness * (1 - saturation * (1 - f));
+	
+	if (h_i == 0)		{ R = brightness;	G = t;			B = p; }
+	else if (h_i == 1)	{ R = q;			G = brightness;	B = p; }
+	else if (h_i == 2)	{ R = p;			G = brightness;	B = t; }
+	else if (h_i == 3)	{ R = p;			G = q;			B = brightness; }
+	else if (h_i == 4)	{ R = t;			G = p;			B = brightness; }
+	else				{ R = brightness;	G = p;			B = q; }
+	
+	*red = (uint8_t)(R * 255.0);
+	*green = (uint8_t)(G * 255.0);
+	*blue = (uint8_t)(B * 255.0);
+}
+
+/**
+ * @brief	The float RGBtoHSB from COLOR_8_BIT
+ */
+static void floatRgbToHsb(uint8_t red, uint8_t green, uint8_t blue, uint16_t *theHue, uint8_t *theSat, uint8_t *theBri)
+{
+	float r = red / 255.0, g = green / 255.0, b = blue / 255.0;
+	float max = r, min = r;
+	if (g > max) max = g;
+	if (b > max) max = b;
+	if (g < min) min = g;
+	if (b < min) min = b;
+	
+	if (max == 0)
+	{
+		*theHue = -1;
+		*theSat = 0;
+		*theBri = -1;
+		return;
+	}
+	
+	float delta = max - min, hue;
+	// The float code divided 0 by 0 for gray, the integer code gives hue 0
+	if (delta == 0) hue = 0;
+	else if (r == max) hue = (g - b) / delta;
+	else if (g == max) hue = 2 + (b - r) / delta;
+	else hue = 4 + (r - g) / delta;
+	
+	hue *= 60;
+	if (hue < 0) hue += 360;
+	
+	*theHue = (int16_t)hue;
+	*theSat = (uint8_t)(delta / max * 100);
+	*theBri = (uint8_t)(max * 100);
+}
+
+/**
+ * @brief	Difference between two values, hue wraps around at 360
+ */
+static int difference(int a, int b, int wrap)
+{
+	int d = abs(a - b);
+	if (wrap && d > wrap / 2) d = wrap - d;
+	return d;
+}
+
+/* Functions -----------------------------------------------------------------*/
+int main()
+{
+	unsigned long errors = 0;
+	
+	for (uint16_t hue = 0; hue < 720; hue++)
+	{
+		for (uint8_t sat = 0; sat <= 100; sat++)
+		{
+			for (uint8_t bright = 0; bright <= 100; bright++)
+			{
+				uint8_t r, g, b, fr, fg, fb;
+				HSBtoRGB8(hue, sat, bright, &r, &g, &b);
+				floatHsbToRgb(hue, sat, bright, &fr, &fg, &fb);
+				if (difference(r, fr, 0) > 1 || difference(g, fg, 0) > 1 || difference(b, fb, 0) > 1)
+				{
+					if (errors++ < 10)
+						printf("HSBtoRGB8(%u, %u, %u) = %u %u %u, float %u %u %u\n",
+								hue, sat, bright, r, g, b, fr, fg, fb);
+				}
+			}
+		}
+	}
+	
+	for (uint32_t color = 0; color < 0x1000000; color++)
+	{
+		uint8_t red = color >> 16, green = color >> 8, blue = color;
+		uint16_t hue, floatHue;
+		uint8_t sat, bright, floatSat, floatBright;
+		RGB8toHSB(red, green, blue, &hue, &sat, &bright);
+		floatRgbToHsb(red, green, blue, &floatHue, &floatSat, &floatBright);
+		if (difference(hue, floatHue, (hue < 360 && floatHue < 360) ? 360 : 0) > 1 ||
+			difference(sat, floatSat, 0) > 1 || difference(bright, floatBright, 0) > 1)
+		{
+			if (errors++ < 10)
+				printf("RGB8toHSB(%u, %u, %u) = %u %u %u, float %u %u %u\n",
+						red, green, blue, hue, sat, bright, floatHue, floatSat, floatBright);
+		}
+	}
+	
+	printf("%lu errors\n", errors);
+	return errors ? 1 : 0;
+}
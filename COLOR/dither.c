@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file	dither.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for temporal dithering of 8-bit PWM outputs
+ *			- A 12 or 16-bit target is shown as the two closest 8-bit levels
+ *			  alternating, so the average over 256 updates is the target
+ *			- First order error accumulator, 3 bytes of state per output
+ *			- DITHER_Next should be called once per PWM period, or as often
+ *			  as possible. At lower rates the pattern becomes visible flicker.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <util/atomic.h>
+#include "dither.h"
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Sets the value to show on an output
+ * @param	Channel: The output to set
+ * @param	Target: The value, 0-65535 where the high byte is the 8-bit level
+ * @retval	None
+ * @note	Can be called while DITHER_Next is used from an ISR
+ */
+void DITHER_SetTarget(DITHER_Channel_TypeDef* Channel, uint16_t Target)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Channel->target = Target;
+	}
+}
+
+/**
+ * @brief	Sets a 12-bit value to show on an output
+ * @param	Channel: The output to set
+ * @param	Target: The value, 0-4095
+ * @retval	None
+ */
+void DITHER_SetTarget12(DITHER_Channel_TypeDef* Channel, uint16_t Target)
+{
+	// Repeat the top bits in the low nibble so 4095 is full scale
+	DITHER_SetTarget(Channel, (Target << 4) | (Target >> 8));
+}
+
+/**
+ * @brief	Gets the 8-bit level to show during the next period
+ * @param	Channel: The output
+ * @retval	The 8-bit level
+ */
+uint8_t DITHER_Next(DITHER_Channel_TypeDef* Channel)
+{
+	uint8_t level = Channel->target >> 8;
+	uint8_t fraction = Channel->target & 0xFF;
+	uint8_t error = Channel->error + fraction;
+	
+	// The fraction is shown as one step up every time the error wraps
+	if (error < fraction && level != 0xFF)
+		level++;
+	Channel->error = error;
+	return level;
+}
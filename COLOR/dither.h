@@ -0,0 +1,34 @@
+/**
+ ******************************************************************************
+ * @file	dither.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains typedefs and function prototypes for temporal dithering
+ *			of 16-bit values to 8-bit PWM outputs
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DITHER_H_
+#define DITHER_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief	State of one dithered output
+ */
+typedef struct
+{
+	uint16_t target;	/** The value to show, 8.8 fixed-point of the 8-bit output */
+	uint8_t error;		/** Accumulated fraction that has not been shown yet */
+} DITHER_Channel_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void DITHER_SetTarget(DITHER_Channel_TypeDef* Channel, uint16_t Target);
+void DITHER_SetTarget12(DITHER_Channel_TypeDef* Channel, uint16_t Target);
+uint8_t DITHER_Next(DITHER_Channel_TypeDef* Channel);
+
+#endif /* DITHER_H_ */
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file	gamma.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for perceptual correction of LED outputs
+ *			- 8-bit to 8-bit table for PCA9633 and the 8-bit timers
+ *			- 8-bit to 12-bit table to drive TLC5947/PCA9685 from 8-bit colors
+ *			- 12-bit to 12-bit with linear interpolation between 65 points
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/pgmspace.h>
+#include "gamma.h"
+
+/* Private defines -----------------------------------------------------------*/
+// Distance between the points in the 12-bit table, the REPEAT_64 below depends on it
+#define GAMMA_12BIT_STEP	64
+#define GAMMA_12BIT_POINTS	(4096 / GAMMA_12BIT_STEP + 1)
+
+/*
+ * The curve that maps a linear input (0.0-1.0) to a PWM duty cycle. GCC folds
+ * __builtin_pow with constant arguments so the tables below end up as
+ * constants in flash and no math library code is linked in.
+ */
+#ifdef GAMMA_CIE
+#define GAMMA_CURVE(X)	((X) <= 0.08 ? (X) * (100.0 / 903.3) : \
+							__builtin_pow(((X) * 100.0 + 16.0) / 116.0, 3.0))
+#else
+#define GAMMA_CURVE(X)	__builtin_pow((X), GAMMA_VALUE)
+#endif
+
+#define GAMMA_ENTRY(X, OUT_FULL)	((uint16_t)(GAMMA_CURVE(X) * (OUT_FULL) + 0.5))
+
+#define ENTRY_8(N)			(uint8_t)GAMMA_ENTRY((N) / 255.0, 255.0),
+#define ENTRY_8TO12(N)		GAMMA_ENTRY((N) / 255.0, 4095.0),
+#define ENTRY_12(N)			GAMMA_ENTRY((N) * GAMMA_12BIT_STEP / 4095.0, 4095.0),
+// The last point is at 4095 so full scale gives full scale
+#define ENTRY_12_LAST		GAMMA_ENTRY(1.0, 4095.0)
+
+#define REPEAT_4(F, N)		F(N) F((N) + 1) F((N) + 2) F((N) + 3)
+#define REPEAT_16(F, N)		REPEAT_4(F, N) REPEAT_4(F, (N) + 4) REPEAT_4(F, (N) + 8) REPEAT_4(F, (N) + 12)
+#define REPEAT_64(F, N)		REPEAT_16(F, N) REPEAT_16(F, (N) + 16) REPEAT_16(F, (N) + 32) REPEAT_16(F, (N) + 48)
+#define REPEAT_256(F)		REPEAT_64(F, 0) REPEAT_64(F, 64) REPEAT_64(F, 128) REPEAT_64(F, 192)
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t _gamma8[256] PROGMEM = { REPEAT_256(ENTRY_8) };
+static const uint16_t _gamma8To12[256] PROGMEM = { REPEAT_256(ENTRY_8TO12) };
+static const uint16_t _gamma12[GAMMA_12BIT_POINTS] PROGMEM = { REPEAT_64(ENTRY_12, 0) ENTRY_12_LAST };
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Corrects an 8-bit value
+ * @param	Value: Linear brightness, 0-255
+ * @retval	PWM value, 0-255
+ */
+uint8_t GAMMA_Correct8(uint8_t Value)
+{
+	return pgm_read_byte(&_gamma8[Value]);
+}
+
+/**
+ * @brief	Corrects an 8-bit value to a 12-bit output, which keeps the
+ *			resolution at the low end
+ * @param	Value: Linear brightness, 0-255
+ * @retval	PWM value, 0-4095
+ */
+uint16_t GAMMA_Correct8To12(uint8_t Value)
+{
+	return pgm_read_word(&_gamma8To12[Value]);
+}
+
+/**
+ * @brief	Corrects a 12-bit value by interpolating between the points in the table
+ * @param	Value: Linear brightness, 0-4095
+ * @retval	PWM value, 0-4095
+ */
+uint16_t GAMMA_Correct12(uint16_t Value)
+{
+	if (Value > 4095) Value = 4095;
+	
+	uint8_t index = Value / GAMMA_12BIT_STEP;
+	uint8_t fraction = Value & (GAMMA_12BIT_STEP - 1);
+	uint16_t low = pgm_read_word(&_gamma12[index]);
+	uint16_t high = pgm_read_word(&_gamma12[index + 1]);
+	
+	// The last segment is one step shorter since it ends at 4095
+	if (index == GAMMA_12BIT_POINTS - 2)
+		return low + (uint16_t)(((uint32_t)(high - low) * fraction) / (GAMMA_12BIT_STEP - 1));
+	return low + (uint16_t)(((uint32_t)(high - low) * fraction) / GAMMA_12BIT_STEP);
+}
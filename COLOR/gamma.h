@@ -0,0 +1,32 @@
+/**
+ ******************************************************************************
+ * @file	gamma.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains function prototypes for perceptual correction of LED
+ *			outputs with lookup tables in flash
+ * @note	The tables are calculated by the compiler. Define GAMMA_VALUE to
+ *			change the exponent or GAMMA_CIE to use the CIE 1931 lightness
+ *			curve instead of a power function.
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef GAMMA_H_
+#define GAMMA_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#ifndef GAMMA_VALUE
+#define GAMMA_VALUE		2.2
+#endif
+
+/* Function prototypes -------------------------------------------------------*/
+uint8_t GAMMA_Correct8(uint8_t Value);
+uint16_t GAMMA_Correct8To12(uint8_t Value);
+uint16_t GAMMA_Correct12(uint16_t Value);
+
+#endif /* GAMMA_H_ */
@@ -7,14 +7,43 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include <atmega328x/timer.h>
 #include "led_strip.h"
+#ifdef LED_STRIP_DITHER
+#include <COLOR/dither.h>
+#endif
 
 #define _ledStripRedColor		OCR1A
-#define _ledStripGreenColor		OCR0A
 #define _ledStripBlueColor		OCR0B
 
-#define TIMER0_PRESCALING	_BV(CS00)
-#define TIMER1_PRESCALING	_BV(CS10)
+#ifdef LED_STRIP_TIMER1
+#define _ledStripGreenColor		OCR1B
+#define LED_STRIP_GREEN_TIMER	TIMER_1
+#define LED_STRIP_GREEN_CHANNEL	TIMER_CHANNEL_B
+// From 16-bit values to TIMER1 compare values, 0-LED_STRIP_TOP
+#define LED_STRIP_SHIFT			(16 - LED_STRIP_PWM_BITS)
+#else
+#define _ledStripGreenColor		OCR0A
+#define LED_STRIP_GREEN_TIMER	TIMER_0
+#define LED_STRIP_GREEN_CHANNEL	TIMER_CHANNEL_A
+#endif
+
+#define LED_STRIP_PRESCALER	TIMER_PRESCALER_1
+
+// Red is always on TIMER1, MILLIS_COUNT has to be moved to TIMER2 with MILLIS_COUNT_TICKLESS
+TIMER_CLAIM(TIMER_0);
+TIMER_CLAIM(TIMER_1);
+
+#ifdef LED_STRIP_DITHER
+// Red, green and blue, only blue is used with LED_STRIP_TIMER1
+DITHER_Channel_TypeDef _ledStripDither[3];
+static void ledStripDitherUpdate();
+#endif
+
+#ifdef LED_STRIP_TIMER1
+// Red, green and blue as 16-bit values, the compare registers only have LED_STRIP_PWM_BITS
+uint16_t _ledStripColor[3];
+#endif
 
 /************************************************************************
 	Initialize the LED-strip
@@ -35,18 +64,47 @@ void initLedStrip()
 		Phase Correct does.
 	*/
 	
+	TIMER_Init_TypeDef timerInit;
+	timerInit.mode = TIMER_PWM_PHASE_CORRECT_0xFF_TOP_MODE;
+	timerInit.prescaler = LED_STRIP_PRESCALER;
+	timerInit.compareA = 0;
+	timerInit.compareB = 0;
+	timerInit.top = 0;
+	
+#ifdef LED_STRIP_TIMER1
+	// Timer 1: Red(A), Green(B) - PWM, Phase and Frequency Correct, TOP = ICR1
+	// No prescaling => Frequency = 8 MHz / 1 / 4095 / 2 = 977 Hz with 12 bits
+	// OCR1A/B are double buffered and updated at BOTTOM so a new value never
+	// gives a short or long pulse
+	timerInit.mode = TIMER1_PWM_PHASE_FREQ_CORRECT_ICR_TOP_MODE;
+	timerInit.top = LED_STRIP_TOP;
+	timerInit.outputA = TIMER_OUTPUT_CLEAR;
+	timerInit.outputB = TIMER_OUTPUT_CLEAR;
+	TIMER_Init(TIMER_1, &timerInit);
+	
+	// Timer 0: Blue(B) - PWM, Phase Correct, 8-bit
+	// No prescaling => Frequency = 8 MHz / 1 / 255 / 2 = 15.686 kHz
+	timerInit.mode = TIMER_PWM_PHASE_CORRECT_0xFF_TOP_MODE;
+	timerInit.top = 0;
+	timerInit.outputA = TIMER_OUTPUT_DISCONNECTED;
+	TIMER_Init(TIMER_0, &timerInit);
+#else
 	// Timer 1: Red(A) - PWM, Phase Correct, 8-bit
-	// No prescaling => Frequency = 8 MHz / 1 / 255 / 2 = 15.686 Hz
-	TCCR1A = _BV(COM1A1) | _BV(WGM10);
-	TCCR1B = TIMER1_PRESCALING;
-	_ledStripRedColor = 0;	
+	// No prescaling => Frequency = 8 MHz / 1 / 255 / 2 = 15.686 kHz
+	timerInit.outputA = TIMER_OUTPUT_CLEAR;
+	timerInit.outputB = TIMER_OUTPUT_DISCONNECTED;
+	TIMER_Init(TIMER_1, &timerInit);
 	
 	// Timer 0: Green(A), Blue(B) - PWM, Phase Correct
-	// No prescaling => Frequency = 8 MHz / 1 / 255 / 2 = 15.686 Hz
-	TCCR0A = _BV(COM0A1) | _BV(COM0B1) | _BV(WGM00);
-	TCCR0B = TIMER0_PRESCALING;
-	_ledStripGreenColor = 0;
-	_ledStripBlueColor = 0;
+	// No prescaling => Frequency = 8 MHz / 1 / 255 / 2 = 15.686 kHz
+	timerInit.outputB = TIMER_OUTPUT_CLEAR;
+	TIMER_Init(TIMER_0, &timerInit);
+#endif
+	
+#ifdef LED_STRIP_DITHER
+	// New levels every PWM period, about 150 cycles of every 510
+	TIMER_SetCallback(TIMER_0, TIMER_EVENT_OVERFLOW, ledStripDitherUpdate);
+#endif
 }
 
 /************************************************************************
@@ -56,23 +114,87 @@ uint8_t setAndShowLedStripRGB(const uint8_t red, const uint8_t green, const uint
 {
 	if (ledStripIsOn() && red < 256 && green < 256 && blue < 256)
 	{
+#if defined(LED_STRIP_TIMER1)
+		// Repeat the bits in the low byte so 255 is full scale
+		setAndShowLedStripRGB16((uint16_t)red << 8 | red, (uint16_t)green << 8 | green, (uint16_t)blue << 8 | blue);
+#elif defined(LED_STRIP_DITHER)
+		DITHER_SetTarget(&_ledStripDither[0], (uint16_t)red << 8);
+		DITHER_SetTarget(&_ledStripDither[1], (uint16_t)green << 8);
+		DITHER_SetTarget(&_ledStripDither[2], (uint16_t)blue << 8);
+#else
 		_ledStripRedColor = red;
 		_ledStripGreenColor = green;
 		_ledStripBlueColor = blue;
+#endif
+		return 1;
+	}
+	else
+		return 0;
+}
+
+#ifdef LED_STRIP_16BIT
+/************************************************************************
+	Set 16-bit data for the different colors. With LED_STRIP_TIMER1 red
+	and green get the top LED_STRIP_PWM_BITS. With LED_STRIP_DITHER the
+	8-bit outputs alternate between the two closest levels every PWM
+	period so the average is the 16-bit value.
+************************************************************************/
+uint8_t setAndShowLedStripRGB16(const uint16_t red, const uint16_t green, const uint16_t blue)
+{
+	if (ledStripIsOn())
+	{
+#ifdef LED_STRIP_TIMER1
+		_ledStripColor[0] = red;
+		_ledStripColor[1] = green;
+		_ledStripColor[2] = blue;
+		_ledStripRedColor = red >> LED_STRIP_SHIFT;
+		_ledStripGreenColor = green >> LED_STRIP_SHIFT;
+#ifdef LED_STRIP_DITHER
+		DITHER_SetTarget(&_ledStripDither[2], blue);
+#else
+		_ledStripBlueColor = blue >> 8;
+#endif
+#else
+		DITHER_SetTarget(&_ledStripDither[0], red);
+		DITHER_SetTarget(&_ledStripDither[1], green);
+		DITHER_SetTarget(&_ledStripDither[2], blue);
+#endif
 		return 1;
 	}
 	else
 		return 0;
 }
+#endif
+
+#ifdef LED_STRIP_DITHER
+/************************************************************************
+	Called from TIMER0_OVF_vect at the bottom of every PWM period, the
+	compare registers are updated by the hardware at the next top
+************************************************************************/
+static void ledStripDitherUpdate()
+{
+#ifndef LED_STRIP_TIMER1
+	_ledStripRedColor = DITHER_Next(&_ledStripDither[0]);
+	_ledStripGreenColor = DITHER_Next(&_ledStripDither[1]);
+#endif
+	_ledStripBlueColor = DITHER_Next(&_ledStripDither[2]);
+}
+#endif
 
 /************************************************************************
 	Set the data from HSB by converting it to RGB
 ************************************************************************/
 void setAndShowLedStripHSB(const uint16_t hue, const uint8_t saturation, const uint8_t brightness)
 {
+#ifdef LED_STRIP_TIMER1
+	uint16_t red, green, blue;
+	HSBtoRGB16(hue, saturation, brightness, &red, &green, &blue);
+	setAndShowLedStripRGB16(red, green, blue);
+#else
 	uint8_t red, green, blue;
-	HSBtoRGB(hue, saturation, brightness, &red, &green, &blue, 8);
+	HSBtoRGB8(hue, saturation, brightness, &red, &green, &blue);
 	setAndShowLedStripRGB(red, green, blue);
+#endif
 }
 
 /************************************************************************
@@ -97,12 +219,13 @@ void turnOnLedStrip()
 void disableLedStripPwm()
 {
 	// Disconnect outputs
-	TCCR0A &= ~(_BV(COM0A1) | _BV(COM0B1));
-	TCCR1A &= ~_BV(COM1A1);
+	TIMER_SetOutput(LED_STRIP_GREEN_TIMER, LED_STRIP_GREEN_CHANNEL, TIMER_OUTPUT_DISCONNECTED);
+	TIMER_SetOutput(TIMER_0, TIMER_CHANNEL_B, TIMER_OUTPUT_DISCONNECTED);
+	TIMER_SetOutput(TIMER_1, TIMER_CHANNEL_A, TIMER_OUTPUT_DISCONNECTED);
 	
 	// Stop timers
-	TCCR0B &= ~(_BV(CS02) | _BV(CS01) | _BV(CS00));
-	TCCR1B &= ~(_BV(CS12) | _BV(CS11) | _BV(CS10));
+	TIMER_Stop(TIMER_0);
+	TIMER_Stop(TIMER_1);
 }
 
 /************************************************************************
@@ -111,12 +234,13 @@ void disableLedStripPwm()
 void enableLedStripPwm()
 {
 	// Connect outputs
-	TCCR0A |= _BV(COM0A1) | _BV(COM0B1);
-	TCCR1A |= _BV(COM1A1);
+	TIMER_SetOutput(LED_STRIP_GREEN_TIMER, LED_STRIP_GREEN_CHANNEL, TIMER_OUTPUT_CLEAR);
+	TIMER_SetOutput(TIMER_0, TIMER_CHANNEL_B, TIMER_OUTPUT_CLEAR);
+	TIMER_SetOutput(TIMER_1, TIMER_CHANNEL_A, TIMER_OUTPUT_CLEAR);
 	
 	// Start timers
-	TCCR0B |= TIMER0_PRESCALING;
-	TCCR1B |= TIMER1_PRESCALING;
+	TIMER_Start(TIMER_0, LED_STRIP_PRESCALER);
+	TIMER_Start(TIMER_1, LED_STRIP_PRESCALER);
 }
 
 
@@ -125,8 +249,9 @@ void enableLedStripPwm()
 ************************************************************************/
 uint8_t ledStripIsOn()
 {
-	return (TCCR0A & (_BV(COM0A1) | _BV(COM0B1)) &&
-			TCCR1A & _BV(COM1A1));
+	return (TIMER_OutputIsConnected(LED_STRIP_GREEN_TIMER, LED_STRIP_GREEN_CHANNEL) &&
+			TIMER_OutputIsConnected(TIMER_0, TIMER_CHANNEL_B) &&
+			TIMER_OutputIsConnected(TIMER_1, TIMER_CHANNEL_A));
 }
 
 
@@ -138,7 +263,11 @@ void ledStripChangeBrightness(const int8_t theChange)
 	uint16_t hue;
 	uint8_t sat, bright;
 	
-	RGBtoHSB(_ledStripRedColor, _ledStripGreenColor, _ledStripBlueColor, &hue, &sat, &bright);
+#ifdef LED_STRIP_TIMER1
+	RGB16toHSB(_ledStripColor[0], _ledStripColor[1], _ledStripColor[2], &hue, &sat, &bright);
+#else
+	RGB8toHSB(_ledStripRedColor, _ledStripGreenColor, _ledStripBlueColor, &hue, &sat, &bright);
+#endif
 	
 	if (bright + theChange <= 100 && bright + theChange > 0)
 	{
@@ -23,15 +23,60 @@
 	Red (PB1):		OC1A
 	Green (PD6):	OC0A
 	Blue (PD5):		OC0B
+
+	With LED_STRIP_TIMER1:
+	Red (PB1):		OC1A
+	Green (PB2):	OC1B
+	Blue (PD5):		OC0B
+
+	TIMER0 and TIMER1 are used in both modes, so MILLIS_COUNT can only be
+	used together with MILLIS_COUNT_TICKLESS.
+*/
+#ifdef TIMER1_IN_USE
+#error "LED strip need TIMER1. Used somewhere else, define MILLIS_COUNT_TICKLESS if it is MILLIS_COUNT"
+#else
+#define TIMER1_IN_USE
+#endif
+
+/*
+	Define LED_STRIP_DITHER to get 16-bit color values by temporal dithering
+	of the 8-bit outputs. Uses the TIMER0 overflow interrupt.
+*/
+
+/*
+	Define LED_STRIP_TIMER1 to run red and green on the 16-bit TIMER1 with
+	LED_STRIP_PWM_BITS of resolution. The PWM frequency is then
+	F_CPU / 2 / (2^LED_STRIP_PWM_BITS - 1), 977 Hz for 12 bits at 8 MHz.
+	Blue stays 8-bit on TIMER0, use LED_STRIP_DITHER to get 16 bits on it.
 */
+#ifdef LED_STRIP_TIMER1
+#ifndef LED_STRIP_PWM_BITS
+#define LED_STRIP_PWM_BITS		12
+#endif
+#if LED_STRIP_PWM_BITS < 8 || LED_STRIP_PWM_BITS > 16
+#error "LED_STRIP_PWM_BITS must be 8-16"
+#endif
+#define LED_STRIP_TOP			((1UL << LED_STRIP_PWM_BITS) - 1)
+#endif
+
+// setAndShowLedStripRGB16 is available
+#if defined(LED_STRIP_DITHER) || defined(LED_STRIP_TIMER1)
+#define LED_STRIP_16BIT
+#endif
 
 // Led Strip Defines
 #define LED_STRIP_RED_DDR		DDRB
 #define LED_STRIP_RED_PORT		PORTB
 #define LED_STRIP_RED_PIN		PORTB1
+#ifdef LED_STRIP_TIMER1
+#define LED_STRIP_GREEN_DDR		DDRB
+#define LED_STRIP_GREEN_PORT	PORTB
+#define LED_STRIP_GREEN_PIN		PORTB2
+#else
 #define LED_STRIP_GREEN_DDR		DDRD
 #define LED_STRIP_GREEN_PORT	PORTD
 #define LED_STRIP_GREEN_PIN		PORTD6
+#endif
 #define LED_STRIP_BLUE_DDR		DDRD
 #define LED_STRIP_BLUE_PORT		PORTD
 #define LED_STRIP_BLUE_PIN		PORTD5
@@ -40,6 +85,9 @@
 
 void initLedStrip();
 uint8_t setAndShowLedStripRGB(const uint8_t red, const uint8_t green, const uint8_t blue);
+#ifdef LED_STRIP_16BIT
+uint8_t setAndShowLedStripRGB16(const uint16_t red, const uint16_t green, const uint16_t blue);
+#endif
 void setAndShowLedStripHSB(const uint16_t hue, const uint8_t saturation, const uint8_t brightness);
 void turnOffLedStrip();
 void turnOnLedStrip();
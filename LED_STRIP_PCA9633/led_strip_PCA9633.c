@@ -8,19 +8,52 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <PCA9633/PCA9633.h>
-#include <COLOR_8_BIT/color_8_bit.h>
+#include <COLOR/color.h>
 #include <DELAY_VAR/delayVar.h>
+#include <MILLIS_COUNT/millis_count.h>
 
 #include "led_strip_PCA9633.h"
 
+#define FADE_HUE			0
+#define FADE_SATURATION		1
+#define FADE_BRIGHTNESS		2
+
+// Fade progress and eased progress are Q15, 32768 is the end of the fade
+#define FADE_PROGRESS_END	32768UL
+
+typedef struct
+{
+	int16_t start;
+	int16_t change;
+	uint32_t startTime;
+	uint16_t duration;
+	uint8_t easing;
+	uint8_t active;
+} ledStripPca9633Fade;
+
 rgb8 ledStripPca9633rgb8;
 hsb _currentHSB;
 
+ledStripPca9633Fade _ledStripFade[3];
+uint8_t _ledStripFadeEasing = LED_STRIP_EASE_LINEAR;
+uint8_t _ledStripOffAfterFade;
+uint8_t _ledStripBrightnessAfterOff;
+
+static void writeHsb(const hsb hsbColor);
+static void writeOutputs(const hsb hsbColor);
+static void startFade(const uint8_t theFade, const int16_t theStart, const int16_t theChange, const uint16_t fadeTime);
+static int16_t fadeValue(ledStripPca9633Fade* theFade, const uint32_t theTime);
+static uint16_t ease(const uint16_t theProgress, const uint8_t theEasing);
+
 /************************************************************************
-	Setup the LED-strip with PCA9633
+	Setup the LED-strip with PCA9633. The strip fades up to the start
+	hue, call ledStripPca9633update() from the main loop to run the fade.
 ************************************************************************/
 void LED_STRIP_PCA9633_Init()
 {
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	
 	pca9633setup();
 	pca9633invertOutputs();
 	pca9633setOeMode(PCA9633_OE_MODE_HIGH_Z);
@@ -28,65 +61,43 @@ void LED_STRIP_PCA9633_Init()
 	
 	ledStripPca9633clear();
 	
-	const uint16_t delayTime = 500;
-	
 	ledStripPca9633switchOn();
-	ledStripPca9633setHsb(0, 100, 0);
-	ledStripPca9633fadeToBrightness(LED_STRIP_MAX_BRIGHT/4, delayTime);
-	ledStripPca9633fadeToBrightness(LED_STRIP_NO_BRIGHT, delayTime);
-	ledStripPca9633setHsb(120, 100, 0);
-	ledStripPca9633fadeToBrightness(LED_STRIP_MAX_BRIGHT/4, delayTime);
-	ledStripPca9633fadeToBrightness(LED_STRIP_NO_BRIGHT, delayTime);
-	ledStripPca9633setHsb(240, 100, 0);
-	ledStripPca9633fadeToBrightness(LED_STRIP_MAX_BRIGHT/4, delayTime);
-	ledStripPca9633fadeToBrightness(LED_STRIP_NO_BRIGHT, delayTime);
-
 	ledStripPca9633setHsb(LED_STRIP_START_HUE, 100, 0);
 	ledStripPca9633fadeToBrightness(LED_STRIP_MAX_BRIGHT, 2000);
 }
 
 void ledStripPca9633setRgbStruct(const rgb8 rgbColor)
 {
+	ledStripPca9633stopFade();
 	if (ledStripPca9633isOn()) 
 	{
 		pca9633setAllOutputs(rgbColor.red, rgbColor.green, rgbColor.blue, 255);
-		RGBtoHSB(rgbColor.red, rgbColor.green, rgbColor.blue, 
+		RGB8toHSB(rgbColor.red, rgbColor.green, rgbColor.blue, 
 				&_currentHSB.hue, &_currentHSB.saturation, &_currentHSB.brightness);
 	}
 }
 
 void ledStripPca9633setRgb(const uint8_t red, const uint8_t green, const uint8_t blue)
 {
+	ledStripPca9633stopFade();
 	if (ledStripPca9633isOn()) 
 	{
 		pca9633setAllOutputs(red, green, blue, 255);
-		RGBtoHSB(red, green, blue,
+		RGB8toHSB(red, green, blue,
 				&_currentHSB.hue, &_currentHSB.saturation, &_currentHSB.brightness);
 	}		
 }
 
 void ledStripPca9633setHsbStruct(const hsb hsbColor)
 {
-	if (ledStripPca9633isOn())
-	{
-		rgb8 rgbColor;
-		HSBtoRGB(hsbColor.hue, hsbColor.saturation, hsbColor.brightness, &rgbColor.red, &rgbColor.green, &rgbColor.blue);
-		_currentHSB = hsbColor;
-		pca9633setAllOutputs(rgbColor.red, rgbColor.green, rgbColor.blue, 255);
-	}	
+	ledStripPca9633stopFade();
+	writeHsb(hsbColor);
 }
 
 void ledStripPca9633setHsb(const uint16_t hue, const uint8_t saturation, const uint8_t brightness)
 {
-	if (ledStripPca9633isOn())
-	{
-		uint8_t red, green, blue;
-		HSBtoRGB(hue, saturation, brightness, &red, &green, &blue);
-		_currentHSB.hue = hue;
-		_currentHSB.saturation = saturation;
-		_currentHSB.brightness = brightness;
-		pca9633setAllOutputs(red, green, blue, 255);
-	}
+	hsb hsbColor = {hue, saturation, brightness};
+	ledStripPca9633setHsbStruct(hsbColor);
 }
 
 void ledStripPca9633clear() { pca9633setAllOutputs(0, 0, 0, 255); }
@@ -109,72 +120,125 @@ void ledStripPca9633switchOff() { pca9633outputOff(); }
 uint8_t ledStripPca9633isOn() { return pca9633outputIsOn(); }
 uint8_t ledStripPca9633isOff() { return !pca9633outputIsOn(); }
 
+/************************************************************************
+	The fade functions only set a target and return immediately. Hue,
+	saturation and brightness have their own targets so they can fade at
+	the same time with different fade times. Starting a new fade of a
+	component replaces the old one and starts from the current value.
+************************************************************************/
 void ledStripPca9633fadeToBrightness(uint8_t newBrightness, uint16_t fadeTime)
-{	
-	if (fadeTime)
-	{
-		int8_t brightChange = newBrightness - _currentHSB.brightness;
-		int16_t iterations;
-		if (brightChange < 0) iterations = -brightChange;
-		else iterations = brightChange;
-		
-		uint16_t delayTime = fadeTime / iterations;
-		hsb newHsb;
-		newHsb.hue = _currentHSB.hue;
-		newHsb.saturation = _currentHSB.saturation;
-		newHsb.brightness = _currentHSB.brightness;
-		
-		for (uint8_t i = 0; i < iterations; i++)
-		{
-			newHsb.brightness += brightChange/iterations;
-			ledStripPca9633setHsbStruct(newHsb);
-			delay_ms(delayTime);
-		}
-	}
-	
-	ledStripPca9633setHsb(_currentHSB.hue, _currentHSB.saturation, newBrightness);
+{
+	_ledStripOffAfterFade = FALSE;
+	startFade(FADE_BRIGHTNESS, _currentHSB.brightness, (int16_t)newBrightness - _currentHSB.brightness, fadeTime);
+}
+
+void ledStripPca9633fadeToSaturation(uint8_t newSaturation, uint16_t fadeTime)
+{
+	startFade(FADE_SATURATION, _currentHSB.saturation, (int16_t)newSaturation - _currentHSB.saturation, fadeTime);
 }
 
 void ledStripPca9633fadeToHue(uint16_t newHue, uint16_t fadeTime)
 {
-	int16_t hueChange = newHue - _currentHSB.hue;
-	if (fadeTime && hueChange < LED_STRIP_HUE_FADE_MAX && hueChange > -LED_STRIP_HUE_FADE_MAX)
-	{
-		int16_t iterations;
-		if (hueChange < 0) iterations = -hueChange;
-		else iterations = hueChange;
-		
-		uint16_t delayTime = fadeTime / iterations;
-		hsb newHsb;
-		newHsb.hue = _currentHSB.hue;
-		newHsb.saturation = _currentHSB.saturation;
-		newHsb.brightness = _currentHSB.brightness;
-		
-		for (uint16_t i = 0; i < iterations; i++)
-		{
-			newHsb.hue += hueChange/iterations;
-			ledStripPca9633setHsbStruct(newHsb);
-			delay_ms(delayTime);
-		}
-	}
+	// Take the shortest way around the color wheel
+	int16_t hueChange = (int16_t)(newHue % 360) - _currentHSB.hue;
+	if (hueChange > 180) hueChange -= 360;
+	else if (hueChange <= -180) hueChange += 360;
 	
-	ledStripPca9633setHsb(newHue, _currentHSB.saturation, _currentHSB.brightness);
+	startFade(FADE_HUE, _currentHSB.hue, hueChange, fadeTime);
+}
+
+void ledStripPca9633fadeToHsb(const hsb hsbColor, uint16_t fadeTime)
+{
+	ledStripPca9633fadeToHue(hsbColor.hue, fadeTime);
+	ledStripPca9633fadeToSaturation(hsbColor.saturation, fadeTime);
+	ledStripPca9633fadeToBrightness(hsbColor.brightness, fadeTime);
 }
 
 void ledStripPca9633fadeOn(uint16_t fadeTime)
 {
-	ledStripPca9633switchOn();
 	uint8_t brightness = _currentHSB.brightness;
-	ledStripPca9633setHsb(_currentHSB.hue, _currentHSB.saturation, LED_STRIP_NO_BRIGHT);
+	if (_ledStripOffAfterFade)
+		brightness = _ledStripBrightnessAfterOff;
+	else
+	{
+		// The PWM registers still have the color from before the switch off
+		_currentHSB.brightness = LED_STRIP_NO_BRIGHT;
+		writeOutputs(_currentHSB);
+		ledStripPca9633switchOn();
+	}
 	ledStripPca9633fadeToBrightness(brightness, fadeTime);
 }
 
 void ledStripPca9633fadeOff(uint16_t fadeTime)
 {
-	uint8_t brightness = _currentHSB.brightness;
-	ledStripPca9633fadeToBrightness(LED_STRIP_NO_BRIGHT, fadeTime);
-	ledStripPca9633setHsb(_currentHSB.hue, _currentHSB.saturation, brightness);
-	ledStripPca9633switchOff();
+	if (!_ledStripOffAfterFade)
+		_ledStripBrightnessAfterOff = _currentHSB.brightness;
+	startFade(FADE_BRIGHTNESS, _currentHSB.brightness, -(int16_t)_currentHSB.brightness, fadeTime);
+	_ledStripOffAfterFade = TRUE;
+}
+
+/************************************************************************
+	Set the easing curve used for fades started after this call
+************************************************************************/
+void ledStripPca9633setEasing(uint8_t easing)
+{
+	_ledStripFadeEasing = easing;
+}
+
+/************************************************************************
+	Stop all fades where they are
+************************************************************************/
+void ledStripPca9633stopFade()
+{
+	for (uint8_t i = 0; i < 3; i++)
+		_ledStripFade[i].active = FALSE;
+	_ledStripOffAfterFade = FALSE;
+}
+
+uint8_t ledStripPca9633isFading()
+{
+	return (_ledStripFade[FADE_HUE].active || _ledStripFade[FADE_SATURATION].active ||
+			_ledStripFade[FADE_BRIGHTNESS].active);
+}
+
+/************************************************************************
+	Advance the fades to the current time. Call this from the main loop,
+	the PCA9633 is only written when the color has changed. Returns TRUE
+	while a fade is running.
+************************************************************************/
+uint8_t ledStripPca9633update()
+{
+	if (!ledStripPca9633isFading())
+		return FALSE;
+	
+	uint32_t now = millis();
+	hsb newHsb = _currentHSB;
+	
+	if (_ledStripFade[FADE_HUE].active)
+	{
+		int16_t hue = fadeValue(&_ledStripFade[FADE_HUE], now);
+		if (hue < 0) hue += 360;
+		else if (hue >= 360) hue -= 360;
+		newHsb.hue = hue;
+	}
+	if (_ledStripFade[FADE_SATURATION].active)
+		newHsb.saturation = fadeValue(&_ledStripFade[FADE_SATURATION], now);
+	if (_ledStripFade[FADE_BRIGHTNESS].active)
+		newHsb.brightness = fadeValue(&_ledStripFade[FADE_BRIGHTNESS], now);
+	
+	if (newHsb.hue != _currentHSB.hue || newHsb.saturation != _currentHSB.saturation ||
+		newHsb.brightness != _currentHSB.brightness)
+		writeHsb(newHsb);
+	
+	if (_ledStripOffAfterFade && !_ledStripFade[FADE_BRIGHTNESS].active)
+	{
+		// Switch off and keep the old brightness for the next switch on
+		ledStripPca9633switchOff();
+		_currentHSB.brightness = _ledStripBrightnessAfterOff;
+		_ledStripOffAfterFade = FALSE;
+	}
+	
+	return ledStripPca9633isFading();
 }
 
 void ledStripPca9633changeBrightness(int8_t change)
@@ -200,4 +264,90 @@ rgb8 ledStripPca9633getRgb()
 hsb ledStripPca9633getHsb()
 {
 	return _currentHSB;
-}
\ No newline at end of file
+}
+
+/************************************************************************
+	Set the current color, it is written to the PCA9633 if the strip is on
+************************************************************************/
+static void writeHsb(const hsb hsbColor)
+{
+	_currentHSB = hsbColor;
+	if (ledStripPca9633isOn())
+		writeOutputs(hsbColor);
+}
+
+/************************************************************************
+	Write a color to the PCA9633 whether the strip is on or not
+************************************************************************/
+static void writeOutputs(const hsb hsbColor)
+{
+	rgb8 rgbColor;
+	HSBtoRGB8(hsbColor.hue, hsbColor.saturation, hsbColor.brightness, &rgbColor.red, &rgbColor.green, &rgbColor.blue);
+	pca9633setAllOutputs(rgbColor.red, rgbColor.green, rgbColor.blue, 255);
+}
+
+/************************************************************************
+	Start a fade of one component from the current time and run the
+	first update so a fade time of 0 is done directly
+************************************************************************/
+static void startFade(const uint8_t theFade, const int16_t theStart, const int16_t theChange, const uint16_t fadeTime)
+{
+	ledStripPca9633Fade* fade = &_ledStripFade[theFade];
+	fade->start = theStart;
+	fade->change = theChange;
+	fade->startTime = millis();
+	fade->duration = fadeTime;
+	fade->easing = _ledStripFadeEasing;
+	fade->active = TRUE;
+	
+	ledStripPca9633update();
+}
+
+/************************************************************************
+	Get the value of a fade at a point in time. The value is calculated
+	from the start of the fade every time so short fades do not lose
+	small steps to rounding. The fade is stopped when it is done.
+************************************************************************/
+static int16_t fadeValue(ledStripPca9633Fade* theFade, const uint32_t theTime)
+{
+	uint32_t elapsed = theTime - theFade->startTime;
+	if (elapsed >= theFade->duration)
+	{
+		theFade->active = FALSE;
+		return theFade->start + theFade->change;
+	}
+	
+	uint16_t progress = ease((elapsed << 15) / theFade->duration, theFade->easing);
+	int32_t change = (int32_t)theFade->change * progress;
+	
+	// Round to nearest, also for negative changes
+	if (change < 0)
+		return theFade->start - (int16_t)((-change + FADE_PROGRESS_END/2) >> 15);
+	else
+		return theFade->start + (int16_t)((change + FADE_PROGRESS_END/2) >> 15);
+}
+
+/************************************************************************
+	Map linear progress to eased progress, both are Q15
+************************************************************************/
+static uint16_t ease(const uint16_t theProgress, const uint8_t theEasing)
+{
+	uint32_t temp;
+	switch (theEasing)
+	{
+		case LED_STRIP_EASE_IN:
+			return ((uint32_t)theProgress * theProgress) >> 15;
+			
+		case LED_STRIP_EASE_OUT:
+			temp = FADE_PROGRESS_END - theProgress;
+			return FADE_PROGRESS_END - ((temp * temp) >> 15);
+			
+		case LED_STRIP_EASE_IN_OUT:
+			// Smoothstep, 3p^2 - 2p^3
+			temp = ((uint32_t)theProgress * (3*FADE_PROGRESS_END - 2*theProgress)) >> 15;
+			return (temp * theProgress) >> 15;
+			
+		default:
+			return theProgress;
+	}
+}
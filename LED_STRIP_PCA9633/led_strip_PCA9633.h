@@ -10,7 +10,7 @@
 
 // Why do I have to include these here?
 #include <avr/io.h>
-#include <COLOR_8_BIT/color_8_bit.h>
+#include <COLOR/color.h>
 
 #ifndef HELP_DEFINITIONS
 #define HELP_DEFINITIONS
@@ -25,7 +25,11 @@
 #define LED_STRIP_MIN_BRIGHT	7
 #define LED_STRIP_MAX_BRIGHT	100
 
-#define LED_STRIP_HUE_FADE_MAX	60
+// Easing curves for the fades
+#define LED_STRIP_EASE_LINEAR	0
+#define LED_STRIP_EASE_IN		1
+#define LED_STRIP_EASE_OUT		2
+#define LED_STRIP_EASE_IN_OUT	3
 
 
 void LED_STRIP_PCA9633_Init();
@@ -45,12 +49,19 @@ uint8_t ledStripPca9633isOn();
 uint8_t ledStripPca9633isOff();
 
 void ledStripPca9633fadeToBrightness(uint8_t newBrightness, uint16_t fadeTime);
+void ledStripPca9633fadeToSaturation(uint8_t newSaturation, uint16_t fadeTime);
 void ledStripPca9633fadeToHue(uint16_t newHue, uint16_t fadeTime);
+void ledStripPca9633fadeToHsb(const hsb hsbColor, uint16_t fadeTime);
 
 void ledStripPca9633fadeOn(uint16_t fadeTime);
 void ledStripPca9633fadeOff(uint16_t fadeTime);
 void ledStripPca9633changeBrightness(int8_t change);
 
+void ledStripPca9633setEasing(uint8_t easing);
+void ledStripPca9633stopFade();
+uint8_t ledStripPca9633isFading();
+uint8_t ledStripPca9633update();
+
 rgb8 ledStripPca9633getRgb();
 hsb ledStripPca9633getHsb();
 
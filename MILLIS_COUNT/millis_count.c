@@ -2,46 +2,109 @@
  ******************************************************************************
  * @file	millis_count.c
  * @author	Hampus Sandberg
- * @version	0.1
+ * @version	0.3
  * @date	2013-03-14
  * @brief	Contains functions to manage a millis counter
+ *			- Millisecond counter driven by the TIMER1 compare interrupt
+ *			- Microsecond time from the counter and a live read of TCNT1
+ *			- Tickless mode with TIMER2 on a 32.768 kHz crystal where the
+ *			  CPU can stay in power-save until the next deadline
+ *			- Statistics for time spent sleeping
  ******************************************************************************
  */
 
 /* Includes ------------------------------------------------------------------*/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/atomic.h>
 
 #include "millis_count.h"
 
 /* Private defines -----------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+// Set when TCNT2 has overflowed but TIMER2_OVF_vect has not been serviced yet
+#define WRAP_PENDING(TICKS)	((TIFR2 & (1 << TOV2)) && (TICKS) < 128)
+
+// A wake-up closer than this many RTC ticks is done by busy waiting
+#define MIN_SLEEP_TICKS		2
+#else
+/*
+ * Set when TCNT1 has wrapped but TIMER1_COMPA_vect has not been serviced yet.
+ * The tick count must then be small, otherwise the wrap happened after TCNT1
+ * was read and the counter is already correct.
+ */
+#define WRAP_PENDING(TICKS)	((TIFR1 & (1 << OCF1A)) && (TICKS) < MILLIS_COUNT_TICKS_PER_MS / 2)
+#endif
+
+// Time comparison that survives the wrap of the millisecond counter
+#define TIME_REACHED(NOW, TIME)	((int32_t)((NOW) - (TIME)) >= 0)
+
 /* Private variables ---------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+TIMER_CLAIM(TIMER_2);
+volatile uint32_t _rtcOverflows;
+#else
+TIMER_CLAIM(TIMER_1);
 volatile uint32_t _millisCounter;
+#endif
 uint8_t _milliCountInitStatus;
+
+uint32_t _sleepStatsStart;
+uint32_t _sleepStatsMillis;
+uint32_t _sleepStatsWakeups;
+
 /* Private functions ---------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+static uint32_t readRtc(uint8_t* Ticks);
+static void waitForRtcSync();
+#endif
+
 /* Functions -----------------------------------------------------------------*/
 
 /**
  * @brief	Initializes the millisecond counter
  * @param	None
  * @retval	None
+ * @note	In tickless mode the crystal needs about a second to stabilize
+ *			after power-up before the time is accurate
  */
 void MILLIS_COUNT_Init()
 {
+#ifdef MILLIS_COUNT_TICKLESS
+	_rtcOverflows = 0;
+	
+	// Switch to asynchronous clock as described in the datasheet
+	TIMSK2 = 0;
+	ASSR = (1 << AS2);
+	TCNT2 = 0;
+	OCR2A = 0;
+	TCCR2A = 0;
+	TCCR2B = MILLIS_COUNT_CLOCK_SELECT;
+	while (ASSR & ((1 << TCN2UB) | (1 << OCR2AUB) | (1 << TCR2AUB) | (1 << TCR2BUB)));
+	TIFR2 = (1 << OCF2A) | (1 << OCF2B) | (1 << TOV2);
+	TIMSK2 = (1 << TOIE2);
+#else
 	_millisCounter = 0;
-	TCCR1B = (1 << CS11) | (1 << WGM12);	// clk/8
-	TIMSK1 = (1 << OCIE1A);
-		
+	
 	// 1 ms per interrupt
-	#if F_CPU == 8000000
-	OCR1A = 1000 - 1;
-	#elif F_CPU == 16000000
-	OCR1A = 2000 - 1;
-	#endif
-		
+	TIMER_Init_TypeDef timerInit;
+	timerInit.mode = TIMER_CTC_MODE;
+	timerInit.prescaler = MILLIS_COUNT_TIMER_PRESCALER;
+	timerInit.outputA = TIMER_OUTPUT_DISCONNECTED;
+	timerInit.outputB = TIMER_OUTPUT_DISCONNECTED;
+	timerInit.compareA = MILLIS_COUNT_TICKS_PER_MS - 1;
+	timerInit.compareB = 0;
+	timerInit.top = 0;
+	TIMER_Init(TIMER_1, &timerInit);
+	
+	TIFR1 = (1 << OCF1A);
+	TIMSK1 = (1 << OCIE1A);
+#endif
+	
 	sei();
 	_milliCountInitStatus = 1;
+	MILLIS_COUNT_ResetSleepStats();
 }
 
 /**
@@ -51,12 +114,18 @@ void MILLIS_COUNT_Init()
  */
 uint32_t millis()
 {
+#ifdef MILLIS_COUNT_TICKLESS
+	uint8_t ticks;
+	uint32_t overflows = readRtc(&ticks);
+	return overflows * MILLIS_COUNT_MS_PER_OVERFLOW + ((ticks * MILLIS_COUNT_MS_PER_OVERFLOW) >> 8);
+#else
 	uint32_t counterCopy;
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
 		counterCopy = _millisCounter;
 	}
 	return counterCopy;
+#endif
 }
 
 /**
@@ -69,6 +138,57 @@ uint16_t millis16bit()
 	return (uint16_t)millis();
 }
 
+/**
+ * @brief	Returns the number of microseconds since MILLIS_COUNT_Init
+ * @param	None
+ * @retval	Current time in microseconds, overflows after approx 71.58 minutes
+ * @note	Resolution is one TIMER1 tick (0.125 us at 8 MHz), or one RTC tick
+ *			in tickless mode
+ */
+uint32_t micros()
+{
+#ifdef MILLIS_COUNT_TICKLESS
+	uint8_t ticks;
+	uint32_t overflows = readRtc(&ticks);
+	return overflows * (MILLIS_COUNT_MS_PER_OVERFLOW * 1000) + ((ticks * (MILLIS_COUNT_MS_PER_OVERFLOW * 1000)) >> 8);
+#else
+	uint32_t millisCopy;
+	uint16_t ticks;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		millisCopy = _millisCounter;
+		ticks = TCNT1;
+		if (WRAP_PENDING(ticks)) millisCopy++;
+	}
+	return millisCopy * 1000 + MILLIS_COUNT_TICKS_TO_US(ticks);
+#endif
+}
+
+/**
+ * @brief	Returns the 2 LSB bytes of the microsecond time
+ * @param	None
+ * @retval	Current time in microseconds, overflows after 65.536 ms
+ * @note	Fast path for measuring short intervals, only 16-bit arithmetic is
+ *			used. Safe to call from an ISR.
+ */
+uint16_t micros16()
+{
+#ifdef MILLIS_COUNT_TICKLESS
+	return (uint16_t)micros();
+#else
+	uint16_t millisCopy;
+	uint16_t ticks;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		// AVR is little endian so the 2 LSB bytes are first in memory
+		millisCopy = *(volatile uint16_t*)&_millisCounter;
+		ticks = TCNT1;
+		if (WRAP_PENDING(ticks)) millisCopy++;
+	}
+	return millisCopy * 1000U + MILLIS_COUNT_TICKS_TO_US(ticks);
+#endif
+}
+
 /**
  * @brief	Checks to see if MILLIS_COUNT has been initialized
  * @param	None
@@ -80,12 +200,151 @@ uint8_t MILLIS_COUNT_Initialized()
 	return _milliCountInitStatus;
 }
 
+/**
+ * @brief	Puts the CPU to sleep until millis() reaches [WakeMillis] or until
+ *			any other interrupt wakes it up
+ * @param	WakeMillis: The millis() value to wake up at
+ * @retval	None
+ * @note	Normal mode uses idle sleep and wakes up on the next millisecond
+ *			tick. Tickless mode uses power-save and programs a TIMER2 compare
+ *			match for the wake-up, or wakes up on the next TIMER2 overflow if
+ *			the deadline is further away. Call it again in a loop after
+ *			checking for work to sleep the whole time.
+ */
+void MILLIS_COUNT_SleepUntil(uint32_t WakeMillis)
+{
+	uint32_t sleepStart = millis();
+	if (TIME_REACHED(sleepStart, WakeMillis)) return;
+	
+#ifdef MILLIS_COUNT_TICKLESS
+	uint32_t remaining = WakeMillis - sleepStart;
+	if (remaining < MILLIS_COUNT_MS_PER_OVERFLOW)
+	{
+		// Round down so the wake-up is never late
+		uint8_t ticks = (remaining << 8) / MILLIS_COUNT_MS_PER_OVERFLOW;
+		if (ticks < MIN_SLEEP_TICKS)
+		{
+			while (!TIME_REACHED(millis(), WakeMillis));
+			return;
+		}
+		
+		uint16_t target = TCNT2 + ticks;
+		if (target <= 0xFF)
+		{
+			OCR2A = target;
+			while (ASSR & (1 << OCR2AUB));
+			TIFR2 = (1 << OCF2A);
+			TIMSK2 |= (1 << OCIE2A);
+		}
+	}
+	set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+#else
+	set_sleep_mode(SLEEP_MODE_IDLE);
+#endif
+	
+	cli();
+	sleep_enable();
+	// sei() makes sure the next instruction (sleep) is executed before any interrupt
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	
+#ifdef MILLIS_COUNT_TICKLESS
+	TIMSK2 &= ~(1 << OCIE2A);
+	waitForRtcSync();
+#endif
+	
+	_sleepStatsWakeups++;
+	_sleepStatsMillis += millis() - sleepStart;
+}
+
+/**
+ * @brief	Gets the statistics for the time spent sleeping since the last reset
+ * @param	Stats: Pointer to where the statistics should be stored
+ * @retval	None
+ */
+void MILLIS_COUNT_GetSleepStats(MILLIS_COUNT_SleepStats_TypeDef* Stats)
+{
+	Stats->totalMillis = millis() - _sleepStatsStart;
+	Stats->sleepMillis = _sleepStatsMillis;
+	Stats->wakeups = _sleepStatsWakeups;
+	// wakeups * 1000 overflows after about 70 minutes at one wake-up per millisecond
+	if (Stats->totalMillis >= 1000000)
+		Stats->wakeupsPerSecond = _sleepStatsWakeups / (Stats->totalMillis / 1000);
+	else if (Stats->totalMillis)
+		Stats->wakeupsPerSecond = _sleepStatsWakeups * 1000 / Stats->totalMillis;
+	else
+		Stats->wakeupsPerSecond = 0;
+}
+
+/**
+ * @brief	Resets the sleep statistics
+ * @param	None
+ * @retval	None
+ */
+void MILLIS_COUNT_ResetSleepStats()
+{
+	_sleepStatsStart = millis();
+	_sleepStatsMillis = 0;
+	_sleepStatsWakeups = 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+/**
+ * @brief	Reads the RTC overflow count and the current TCNT2 value
+ * @param	Ticks: Pointer to where TCNT2 should be stored
+ * @retval	Number of TIMER2 overflows
+ */
+static uint32_t readRtc(uint8_t* Ticks)
+{
+	uint32_t overflows;
+	uint8_t ticks;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		overflows = _rtcOverflows;
+		ticks = TCNT2;
+		if (WRAP_PENDING(ticks)) overflows++;
+	}
+	*Ticks = ticks;
+	return overflows;
+}
+
+/**
+ * @brief	Waits for one TOSC1 cycle by doing a dummy write to OCR2B
+ * @param	None
+ * @retval	None
+ * @note	After waking up TCNT2 can read the value from before sleeping,
+ *			and the interrupt logic needs one TOSC1 cycle before the CPU can
+ *			go back to power-save
+ */
+static void waitForRtcSync()
+{
+	OCR2B = 0;
+	while (ASSR & (1 << OCR2BUB));
+}
+#endif
 
 /* Interrupt Service Routines ------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+/**
+ * @brief	Counts RTC overflows, the time is calculated from this and TCNT2
+ */
+ISR(TIMER2_OVF_vect)
+{
+	_rtcOverflows++;
+}
+
+/**
+ * @brief	Only used to wake up the CPU from MILLIS_COUNT_SleepUntil
+ */
+EMPTY_INTERRUPT(TIMER2_COMPA_vect);
+#else
 /**
  * @brief	Will increase the counter by 1 every millisecond
  */
 ISR(TIMER1_COMPA_vect)
 {
 	_millisCounter++;
-}
\ No newline at end of file
+}
+#endif
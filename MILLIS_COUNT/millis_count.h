@@ -2,10 +2,12 @@
  ******************************************************************************
  * @file	millis_count.h
  * @author	Hampus Sandberg
- * @version	0.1
+ * @version	0.2
  * @date	2013-03-14
  * @brief	Contains function prototypes to manage a millisecond counter
- * @note	Relies on TIMER1 so it should not be used anywhere else
+ * @note	Relies on TIMER1 so it should not be used anywhere else. When
+ *			MILLIS_COUNT_TICKLESS is defined TIMER2 is used instead, clocked
+ *			asynchronously from a 32.768 kHz crystal on TOSC1/TOSC2
  ******************************************************************************
  */
 
@@ -14,18 +16,113 @@
 #define MILLIS_COUNT_H_
 
 /* Includes ------------------------------------------------------------------*/
+#include <atmega328x/timer.h>
+
 /* Defines -------------------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+
+#ifdef TIMER2_IN_USE
+#error "Milliscount need TIMER2 in tickless mode. Used somewhere else"
+#else
+#define TIMER2_IN_USE
+#endif
+
+/*
+ * TIMER2 counts the 32.768 kHz crystal divided by MILLIS_COUNT_RTC_PRESCALER
+ * and only interrupts on overflow, or on compare match when a wake-up has been
+ * programmed. The prescaler must be 32 or higher so one overflow period is a
+ * whole number of milliseconds. The resolution of millis() is one RTC tick.
+ */
+#ifndef MILLIS_COUNT_RTC_PRESCALER
+#define MILLIS_COUNT_RTC_PRESCALER	32
+#endif
+
+#if MILLIS_COUNT_RTC_PRESCALER == 32
+#define MILLIS_COUNT_CLOCK_SELECT	((1 << CS21) | (1 << CS20))
+#elif MILLIS_COUNT_RTC_PRESCALER == 64
+#define MILLIS_COUNT_CLOCK_SELECT	(1 << CS22)
+#elif MILLIS_COUNT_RTC_PRESCALER == 128
+#define MILLIS_COUNT_CLOCK_SELECT	((1 << CS22) | (1 << CS20))
+#elif MILLIS_COUNT_RTC_PRESCALER == 256
+#define MILLIS_COUNT_CLOCK_SELECT	((1 << CS22) | (1 << CS21))
+#elif MILLIS_COUNT_RTC_PRESCALER == 1024
+#define MILLIS_COUNT_CLOCK_SELECT	((1 << CS22) | (1 << CS21) | (1 << CS20))
+#else
+#error "MILLIS_COUNT_RTC_PRESCALER must be 32, 64, 128, 256 or 1024"
+#endif
+
+// 256 ticks * prescaler / 32768 Hz
+#define MILLIS_COUNT_MS_PER_OVERFLOW	(MILLIS_COUNT_RTC_PRESCALER * 125UL / 16)
+
+#else
+
 #ifdef TIMER1_IN_USE
 #error "Milliscount need TIMER1. Used somewhere else"
 #else
 #define TIMER1_IN_USE
 #endif
 
+#ifndef F_CPU
+#error "F_CPU is not defined"
+#endif
+
+/*
+ * TIMER1 runs in CTC mode and wraps once every millisecond. Use the smallest
+ * prescaler where one millisecond still fits in the 16-bit counter to get the
+ * best resolution for micros()
+ */
+#if (F_CPU / 1000UL) <= 0x10000UL
+#define MILLIS_COUNT_PRESCALER		1
+#define MILLIS_COUNT_TIMER_PRESCALER	TIMER_PRESCALER_1
+#else
+#define MILLIS_COUNT_PRESCALER		8
+#define MILLIS_COUNT_TIMER_PRESCALER	TIMER_PRESCALER_8
+#endif
+
+#define MILLIS_COUNT_TICKS_PER_MS	(F_CPU / MILLIS_COUNT_PRESCALER / 1000UL)
+
+#if (F_CPU % (MILLIS_COUNT_PRESCALER * 1000UL)) != 0
+#warning "F_CPU is not a multiple of 1 kHz, millis() will drift slightly"
+#endif
+
+/*
+ * Conversion from TIMER1 ticks (always less than MILLIS_COUNT_TICKS_PER_MS) to
+ * microseconds. A whole number of ticks per microsecond gives a plain division
+ * by a constant (a shift for 8 and 16 MHz), otherwise a 16.16 fixed-point
+ * multiply is used.
+ */
+#if (MILLIS_COUNT_TICKS_PER_MS % 1000UL) == 0
+#define MILLIS_COUNT_TICKS_PER_US		(MILLIS_COUNT_TICKS_PER_MS / 1000UL)
+#define MILLIS_COUNT_TICKS_TO_US(TICKS)	((uint16_t)(TICKS) / (uint16_t)MILLIS_COUNT_TICKS_PER_US)
+#else
+#define MILLIS_COUNT_US_PER_TICK_Q16	((1000UL * 65536UL) / MILLIS_COUNT_TICKS_PER_MS)
+#define MILLIS_COUNT_TICKS_TO_US(TICKS)	((uint16_t)(((uint32_t)(TICKS) * MILLIS_COUNT_US_PER_TICK_Q16) >> 16))
+#endif
+
+#endif /* MILLIS_COUNT_TICKLESS */
+
 /* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief	Statistics for the time spent sleeping in MILLIS_COUNT_SleepUntil
+ */
+typedef struct
+{
+	uint32_t totalMillis;		/** Time since the statistics were reset */
+	uint32_t sleepMillis;		/** Time spent sleeping since the statistics were reset */
+	uint32_t wakeups;			/** Number of wake-ups since the statistics were reset */
+	uint16_t wakeupsPerSecond;	/** Average number of wake-ups per second */
+} MILLIS_COUNT_SleepStats_TypeDef;
+
 /* Function prototypes -------------------------------------------------------*/
 void MILLIS_COUNT_Init();
 uint32_t millis();
 uint16_t millis16bit();
+uint32_t micros();
+uint16_t micros16();
 uint8_t MILLIS_COUNT_Initialized();
 
-#endif /* MILLIS_COUNT_H_ */
\ No newline at end of file
+void MILLIS_COUNT_SleepUntil(uint32_t WakeMillis);
+void MILLIS_COUNT_GetSleepStats(MILLIS_COUNT_SleepStats_TypeDef* Stats);
+void MILLIS_COUNT_ResetSleepStats();
+
+#endif /* MILLIS_COUNT_H_ */
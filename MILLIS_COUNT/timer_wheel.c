@@ -0,0 +1,264 @@
+/**
+ ******************************************************************************
+ * @file	timer_wheel.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for a hashed timer wheel
+ *			- One slot per millisecond, a timer is put in the slot given by
+ *			  the low bits of its expiry time
+ *			- O(1) start and cancel
+ *			- Each millisecond only the timers in one slot are looked at
+ *			- Expired timers call a callback and/or set a flag
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <assert/assert.h>
+#include "millis_count.h"
+#include "timer_wheel.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define SLOT(TIME)	((uint8_t)(TIME) & SLOT_MASK)
+
+// Time comparison that survives the wrap of the millisecond counter
+#define TIME_REACHED(NOW, TIME)	((int32_t)((NOW) - (TIME)) >= 0)
+
+/* Private variables ---------------------------------------------------------*/
+TIMER_WHEEL_Timer_TypeDef* _timerWheelSlots[TIMER_WHEEL_SLOTS];
+uint32_t _timerWheelLastProcessed;
+
+/* Private functions ---------------------------------------------------------*/
+static void insertTimer(TIMER_WHEEL_Timer_TypeDef* Timer);
+static void removeTimer(TIMER_WHEEL_Timer_TypeDef* Timer);
+static void processSlot(uint8_t Slot, uint32_t Now);
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes the timer wheel and MILLIS_COUNT if it is not already initialized
+ * @param	None
+ * @retval	None
+ */
+void TIMER_WHEEL_Init()
+{
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	
+	for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++)
+		_timerWheelSlots[i] = 0;
+	_timerWheelLastProcessed = millis();
+}
+
+/**
+ * @brief	Starts a timer. If the timer is already running it is restarted.
+ * @param	Timer: The timer to start
+ * @param	Timeout: Time in ms until the timer expires
+ * @param	Period: Time in ms between expiries after the first one, 0 for a one-shot timer
+ * @param	Callback: Function to call when the timer expires, 0 to only set the expired flag
+ * @retval	None
+ */
+void TIMER_WHEEL_Start(TIMER_WHEEL_Timer_TypeDef* Timer, uint16_t Timeout, uint16_t Period,
+					TIMER_WHEEL_Callback_TypeDef Callback)
+{
+	assert_param(Timer != 0);
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (Timer->flags & TIMER_WHEEL_RUNNING)
+			removeTimer(Timer);
+		
+		Timer->expires = millis() + Timeout;
+		// The slot for the current millisecond might already be processed
+		if (!TIME_REACHED(Timer->expires, _timerWheelLastProcessed + 1))
+			Timer->expires = _timerWheelLastProcessed + 1;
+		Timer->period = Period;
+		Timer->callback = Callback;
+		Timer->flags = TIMER_WHEEL_RUNNING;
+		insertTimer(Timer);
+	}
+}
+
+/**
+ * @brief	Stops a timer without calling its callback
+ * @param	Timer: The timer to stop
+ * @retval	None
+ */
+void TIMER_WHEEL_Cancel(TIMER_WHEEL_Timer_TypeDef* Timer)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (Timer->flags & TIMER_WHEEL_RUNNING)
+			removeTimer(Timer);
+		Timer->flags = 0;
+	}
+}
+
+/**
+ * @brief	Checks if a timer is running
+ * @param	Timer: The timer to check
+ * @retval	1: The timer is running
+ * @retval	0: The timer is stopped
+ */
+uint8_t TIMER_WHEEL_IsRunning(TIMER_WHEEL_Timer_TypeDef* Timer)
+{
+	return (Timer->flags & TIMER_WHEEL_RUNNING) != 0;
+}
+
+/**
+ * @brief	Checks if a timer has expired since the last call and clears the flag
+ * @param	Timer: The timer to check
+ * @retval	1: The timer has expired
+ * @retval	0: The timer has not expired
+ */
+uint8_t TIMER_WHEEL_HasExpired(TIMER_WHEEL_Timer_TypeDef* Timer)
+{
+	uint8_t expired = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (Timer->flags & TIMER_WHEEL_EXPIRED)
+		{
+			Timer->flags &= ~TIMER_WHEEL_EXPIRED;
+			expired = 1;
+		}
+	}
+	return expired;
+}
+
+/**
+ * @brief	Expires all timers that are due. One slot is looked at for every
+ *			millisecond that has passed since the last call.
+ * @param	None
+ * @retval	None
+ * @note	Call this from the main loop or as a scheduler task. The callbacks
+ *			are run from here.
+ */
+void TIMER_WHEEL_Process()
+{
+	uint32_t now = millis();
+	uint32_t elapsed = now - _timerWheelLastProcessed;
+	
+	if (elapsed >= TIMER_WHEEL_SLOTS)
+	{
+		// A full revolution or more has passed, every slot has to be checked once.
+		// Timers started by the callbacks are then put after now and not in a
+		// slot that has already been checked.
+		_timerWheelLastProcessed = now;
+		for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+			processSlot(slot, now);
+	}
+	else
+	{
+		while (elapsed--)
+			processSlot(SLOT(++_timerWheelLastProcessed), now);
+	}
+}
+
+/**
+ * @brief	Finds the expiry time of the timer that will expire first
+ * @param	Expires: Pointer to where the expiry time should be stored
+ * @retval	1: A timer is running and Expires is valid
+ * @retval	0: No timer is running
+ * @note	Looks at every running timer, intended for deciding how long the
+ *			CPU can sleep and not for use every tick
+ */
+uint8_t TIMER_WHEEL_NextExpiry(uint32_t* Expires)
+{
+	uint8_t found = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+		{
+			for (TIMER_WHEEL_Timer_TypeDef* timer = _timerWheelSlots[slot]; timer; timer = timer->next)
+			{
+				if (!found || (int32_t)(timer->expires - *Expires) < 0)
+				{
+					*Expires = timer->expires;
+					found = 1;
+				}
+			}
+		}
+	}
+	return found;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Puts a timer first in the slot for its expiry time
+ * @param	Timer: The timer to insert
+ * @retval	None
+ * @note	Must be called with interrupts disabled
+ */
+static void insertTimer(TIMER_WHEEL_Timer_TypeDef* Timer)
+{
+	TIMER_WHEEL_Timer_TypeDef** head = &_timerWheelSlots[SLOT(Timer->expires)];
+	Timer->prev = 0;
+	Timer->next = *head;
+	if (*head) (*head)->prev = Timer;
+	*head = Timer;
+}
+
+/**
+ * @brief	Unlinks a timer from its slot
+ * @param	Timer: The timer to remove
+ * @retval	None
+ * @note	Must be called with interrupts disabled
+ */
+static void removeTimer(TIMER_WHEEL_Timer_TypeDef* Timer)
+{
+	if (Timer->prev) Timer->prev->next = Timer->next;
+	else _timerWheelSlots[SLOT(Timer->expires)] = Timer->next;
+	if (Timer->next) Timer->next->prev = Timer->prev;
+}
+
+/**
+ * @brief	Expires the timers in a slot that are due. Timers in the same slot
+ *			that belong to a later revolution are left alone.
+ * @param	Slot: The slot to process
+ * @param	Now: Current millis() value
+ * @retval	None
+ * @note	The list is searched again from the head after every callback since
+ *			the callback is allowed to start and cancel any timer
+ */
+static void processSlot(uint8_t Slot, uint32_t Now)
+{
+	while (1)
+	{
+		TIMER_WHEEL_Timer_TypeDef* timer;
+		TIMER_WHEEL_Callback_TypeDef callback;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			for (timer = _timerWheelSlots[Slot]; timer; timer = timer->next)
+			{
+				if (TIME_REACHED(Now, timer->expires)) break;
+			}
+			
+			if (timer)
+			{
+				removeTimer(timer);
+				callback = timer->callback;
+				if (timer->period)
+				{
+					do
+					{
+						timer->expires += timer->period;
+					} while (TIME_REACHED(Now, timer->expires));
+					timer->flags |= TIMER_WHEEL_EXPIRED;
+					insertTimer(timer);
+				}
+				else
+				{
+					timer->flags = TIMER_WHEEL_EXPIRED;
+				}
+			}
+		}
+		
+		if (!timer) break;
+		if (callback) callback(timer);
+	}
+}
+
+/* Interrupt Service Routines ------------------------------------------------*/
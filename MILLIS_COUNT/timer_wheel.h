@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file	timer_wheel.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains typedefs and function prototypes for a hashed timer wheel
+ *			that handles many software timers on top of MILLIS_COUNT
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Defines -------------------------------------------------------------------*/
+/*
+ * Number of slots in the wheel, must be a power of 2. Timers that expire more
+ * than TIMER_WHEEL_SLOTS ms in the future share slots with closer timers and
+ * are skipped until their revolution comes around.
+ */
+#ifndef TIMER_WHEEL_SLOTS
+#define TIMER_WHEEL_SLOTS	32
+#endif
+
+#if (TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1)) != 0
+#error "TIMER_WHEEL_SLOTS must be a power of 2"
+#endif
+
+#define TIMER_WHEEL_RUNNING	0x01
+#define TIMER_WHEEL_EXPIRED	0x02
+
+/* Typedefs ------------------------------------------------------------------*/
+struct TIMER_WHEEL_Timer;
+
+/**
+ * @brief	Typedef for a pointer to a function that is called when a timer expires
+ */
+typedef void (*TIMER_WHEEL_Callback_TypeDef)(struct TIMER_WHEEL_Timer* Timer);
+
+/**
+ * @brief	A software timer. The memory is owned by the user and the timer is
+ *			linked into the wheel while it is running, so no allocation is done
+ *			and start/cancel are O(1).
+ */
+typedef struct TIMER_WHEEL_Timer
+{
+	struct TIMER_WHEEL_Timer* next;			/** Next timer in the same slot */
+	struct TIMER_WHEEL_Timer* prev;			/** Previous timer in the same slot */
+	uint32_t expires;						/** millis() value when the timer expires */
+	uint16_t period;						/** Reload value in ms, 0 for a one-shot timer */
+	TIMER_WHEEL_Callback_TypeDef callback;	/** Function to call on expiry, can be 0 */
+	volatile uint8_t flags;					/** TIMER_WHEEL_RUNNING and TIMER_WHEEL_EXPIRED */
+} TIMER_WHEEL_Timer_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void TIMER_WHEEL_Init();
+void TIMER_WHEEL_Start(TIMER_WHEEL_Timer_TypeDef* Timer, uint16_t Timeout, uint16_t Period,
+					TIMER_WHEEL_Callback_TypeDef Callback);
+void TIMER_WHEEL_Cancel(TIMER_WHEEL_Timer_TypeDef* Timer);
+uint8_t TIMER_WHEEL_IsRunning(TIMER_WHEEL_Timer_TypeDef* Timer);
+uint8_t TIMER_WHEEL_HasExpired(TIMER_WHEEL_Timer_TypeDef* Timer);
+
+void TIMER_WHEEL_Process();
+uint8_t TIMER_WHEEL_NextExpiry(uint32_t* Expires);
+
+#endif /* TIMER_WHEEL_H_ */
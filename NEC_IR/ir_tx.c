@@ -0,0 +1,320 @@
+/**
+ ******************************************************************************
+ * @file	ir_tx.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for an IR transmitter
+ *			- 38 kHz carrier from TIMER2 in CTC mode
+ *			- The mark/space schedule of a frame is calculated before it is
+ *			  sent and played back from the TIMER1 compare B interrupt, which
+ *			  shares the millisecond timebase of MILLIS_COUNT
+ *			- NEC (8 and 16-bit address), NEC repeat codes and RC5
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <assert/assert.h>
+#include <atmega328x/timer.h>
+#include "ir_tx.h"
+
+/* Private defines -----------------------------------------------------------*/
+#ifdef IR_TX_USE_OC2B
+#define CARRIER_CHANNEL		TIMER_CHANNEL_B
+#define CARRIER_PORT		PORTD
+#define CARRIER_DDR			DDRD
+#define CARRIER_PIN			PORTD3
+#else
+#define CARRIER_CHANNEL		TIMER_CHANNEL_A
+#define CARRIER_PORT		PORTB
+#define CARRIER_DDR			DDRB
+#define CARRIER_PIN			PORTB3
+#endif
+
+// Time in microseconds from the start of one frame to the start of the next
+#define NEC_FRAME_PERIOD	108000UL
+#define RC5_FRAME_PERIOD	113778UL
+
+#define RC5_HALF_BIT		889
+
+/* Private typedefs ----------------------------------------------------------*/
+/**
+ * @brief	When to do the next edge. The compare match happens once every
+ *			millisecond so [skip] matches are ignored before the edge is done.
+ */
+typedef struct
+{
+	uint16_t compare;
+	uint8_t skip;
+} Edge_TypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+TIMER_CLAIM(TIMER_2);
+
+Edge_TypeDef _irTxSchedule[IR_TX_MAX_EDGES];
+uint8_t _irTxLength;
+volatile uint8_t _irTxIndex;
+volatile uint8_t _irTxSkip;
+volatile uint8_t _irTxBusy;
+
+// Used while the schedule is built
+uint16_t _irTxPosition;
+uint32_t _irTxElapsed;
+uint32_t _irTxPendingMicros;
+uint8_t _irTxPendingIsMark;
+
+/* Private functions ---------------------------------------------------------*/
+static void beginSchedule();
+static void addSegment(uint8_t IsMark, uint16_t Micros);
+static void addEdge(uint32_t Micros);
+static void endSchedule(uint32_t FramePeriod);
+static void startSchedule();
+static void compareCallback();
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes the IR transmitter and MILLIS_COUNT if it is not already initialized
+ * @param	None
+ * @retval	None
+ */
+void IR_TX_Init()
+{
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	
+	// The carrier runs all the time, it is gated by connecting the output
+	TIMER_Init_TypeDef timerInit;
+	timerInit.mode = TIMER_CTC_MODE;
+	timerInit.prescaler = IR_TX_CARRIER_PRESCALER;
+	timerInit.outputA = TIMER_OUTPUT_DISCONNECTED;
+	timerInit.outputB = TIMER_OUTPUT_DISCONNECTED;
+	timerInit.compareA = IR_TX_CARRIER_TOP;
+	timerInit.compareB = 0;
+	timerInit.top = 0;
+	TIMER_Init(TIMER_2, &timerInit);
+	
+	// Drive the LED off while the output is disconnected instead of leaving it floating
+	CARRIER_PORT &= ~(1 << CARRIER_PIN);
+	CARRIER_DDR |= (1 << CARRIER_PIN);
+	TIMER_SetOutput(TIMER_2, CARRIER_CHANNEL, TIMER_OUTPUT_DISCONNECTED);
+	_irTxBusy = 0;
+}
+
+/**
+ * @brief	Starts sending a NEC frame
+ * @param	Address: The address, values above 0xFF are sent as a 16-bit extended address
+ * @param	Command: The command
+ * @retval	1: The frame is being sent
+ * @retval	0: Busy with the previous frame
+ * @note	The transmitter is busy for 108 ms so frames can be sent back to back
+ */
+uint8_t IR_TX_SendNEC(uint16_t Address, uint8_t Command)
+{
+	if (_irTxBusy) return 0;
+	
+	uint8_t addressHigh = (Address > 0xFF) ? (Address >> 8) : ~Address;
+	uint32_t data = (uint32_t)(Address & 0xFF) | 
+					((uint32_t)addressHigh << 8) | 
+					((uint32_t)Command << 16) | 
+					((uint32_t)(uint8_t)~Command << 24);
+	
+	beginSchedule();
+	addSegment(1, 9000);
+	addSegment(0, 4500);
+	for (uint8_t i = 0; i < 32; i++)
+	{
+		addSegment(1, 560);
+		addSegment(0, (data & 1) ? 1690 : 560);
+		data >>= 1;
+	}
+	addSegment(1, 560);
+	endSchedule(NEC_FRAME_PERIOD);
+	startSchedule();
+	return 1;
+}
+
+/**
+ * @brief	Starts sending a NEC repeat code
+ * @param	None
+ * @retval	1: The repeat code is being sent
+ * @retval	0: Busy with the previous frame
+ * @note	Should be sent when the transmitter is no longer busy after
+ *			IR_TX_SendNEC or the previous repeat code
+ */
+uint8_t IR_TX_SendNECRepeat()
+{
+	if (_irTxBusy) return 0;
+	
+	beginSchedule();
+	addSegment(1, 9000);
+	addSegment(0, 2250);
+	addSegment(1, 560);
+	endSchedule(NEC_FRAME_PERIOD);
+	startSchedule();
+	return 1;
+}
+
+/**
+ * @brief	Starts sending an RC5 frame
+ * @param	Address: The address, 0-31
+ * @param	Command: The command, 0-127 where 64-127 use the extended RC5 format
+ * @param	Toggle: Should be changed for every new button press
+ * @retval	1: The frame is being sent
+ * @retval	0: Busy with the previous frame
+ */
+uint8_t IR_TX_SendRC5(uint8_t Address, uint8_t Command, uint8_t Toggle)
+{
+	assert_param(Address < 32);
+	assert_param(Command < 128);
+	
+	if (_irTxBusy) return 0;
+	
+	// Start bit, inverted command bit 6, toggle, 5 bits address, 6 bits command
+	uint16_t data = (1 << 13) | (Toggle ? (1 << 11) : 0) | ((uint16_t)(Address & 0x1F) << 6) | (Command & 0x3F);
+	if (!(Command & 0x40)) data |= (1 << 12);
+	
+	beginSchedule();
+	for (uint16_t mask = (1 << 13); mask; mask >>= 1)
+	{
+		// A one is space then mark, a zero is mark then space
+		uint8_t bit = (data & mask) != 0;
+		addSegment(!bit, RC5_HALF_BIT);
+		addSegment(bit, RC5_HALF_BIT);
+	}
+	endSchedule(RC5_FRAME_PERIOD);
+	startSchedule();
+	return 1;
+}
+
+/**
+ * @brief	Checks if a frame is being sent
+ * @param	None
+ * @retval	1: Busy
+ * @retval	0: Ready to send
+ */
+uint8_t IR_TX_IsBusy()
+{
+	return _irTxBusy;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Starts a new schedule. The first edge is at the next millisecond
+ *			boundary, when TCNT1 is 0, so the schedule does not depend on when
+ *			it is started.
+ * @param	None
+ * @retval	None
+ */
+static void beginSchedule()
+{
+	_irTxLength = 1;
+	_irTxSchedule[0].compare = 0;
+	_irTxSchedule[0].skip = 0;
+	_irTxPosition = 0;
+	_irTxElapsed = 0;
+	_irTxPendingMicros = 0;
+	_irTxPendingIsMark = 1;
+}
+
+/**
+ * @brief	Adds a mark or space, following segments with the same level are merged
+ * @param	IsMark: 1 for carrier on, 0 for off
+ * @param	Micros: Length in microseconds
+ * @retval	None
+ */
+static void addSegment(uint8_t IsMark, uint16_t Micros)
+{
+	// A leading space is part of the idle time before the frame
+	if (!IsMark && _irTxLength == 1 && !_irTxPendingMicros) return;
+	
+	if (IsMark != _irTxPendingIsMark)
+	{
+		if (_irTxPendingMicros) addEdge(_irTxPendingMicros);
+		_irTxPendingIsMark = IsMark;
+		_irTxPendingMicros = 0;
+	}
+	_irTxPendingMicros += Micros;
+}
+
+/**
+ * @brief	Adds an edge [Micros] after the previous one
+ * @param	Micros: Time since the previous edge
+ * @retval	None
+ */
+static void addEdge(uint32_t Micros)
+{
+	assert_param(_irTxLength < IR_TX_MAX_EDGES);
+	
+	_irTxElapsed += Micros;
+	uint32_t position = _irTxPosition + (Micros * MILLIS_COUNT_TICKS_PER_MS + 500) / 1000;
+	uint8_t wraps = position / MILLIS_COUNT_TICKS_PER_MS;
+	uint16_t compare = position % MILLIS_COUNT_TICKS_PER_MS;
+	
+	// A match later in the current millisecond comes before the first wrap
+	Edge_TypeDef* edge = &_irTxSchedule[_irTxLength++];
+	edge->compare = compare;
+	edge->skip = (compare > _irTxPosition) ? wraps : wraps - 1;
+	_irTxPosition = compare;
+}
+
+/**
+ * @brief	Ends the schedule with the last mark and a space so the next frame
+ *			can start when the transmitter is no longer busy
+ * @param	FramePeriod: Time from the start of the frame to the start of the next
+ * @retval	None
+ */
+static void endSchedule(uint32_t FramePeriod)
+{
+	// The last segment is always a mark
+	addEdge(_irTxPendingMicros);
+	addEdge(FramePeriod - _irTxElapsed);
+}
+
+/**
+ * @brief	Starts playing back the schedule from the TIMER1 compare B interrupt
+ * @param	None
+ * @retval	None
+ */
+static void startSchedule()
+{
+	_irTxBusy = 1;
+	_irTxIndex = 0;
+	_irTxSkip = _irTxSchedule[0].skip;
+	TIMER_SetCompare(TIMER_1, TIMER_CHANNEL_B, _irTxSchedule[0].compare);
+	TIFR1 = (1 << OCF1B);
+	TIMER_SetCallback(TIMER_1, TIMER_EVENT_COMPARE_B, compareCallback);
+}
+
+/**
+ * @brief	Called from TIMER1_COMPB_vect once every millisecond while a frame
+ *			is sent. Even edges turn the carrier on and odd edges turn it off.
+ * @param	None
+ * @retval	None
+ */
+static void compareCallback()
+{
+	if (_irTxSkip)
+	{
+		_irTxSkip--;
+		return;
+	}
+	
+	uint8_t index = _irTxIndex++;
+	if (index == _irTxLength - 1)
+	{
+		// End of the gap after the frame, TIMER_SetCallback can not be used in an ISR
+		TIMSK1 &= ~(1 << OCIE1B);
+		_irTxBusy = 0;
+		return;
+	}
+	
+	if (index & 1)
+		TIMER_SetOutput(TIMER_2, CARRIER_CHANNEL, TIMER_OUTPUT_DISCONNECTED);
+	else
+		TIMER_SetOutput(TIMER_2, CARRIER_CHANNEL, TIMER_OUTPUT_TOGGLE);
+	
+	OCR1B = _irTxSchedule[index + 1].compare;
+	_irTxSkip = _irTxSchedule[index + 1].skip;
+}
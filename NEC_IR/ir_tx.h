@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file	ir_tx.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains function prototypes for an IR transmitter that sends NEC
+ *			and RC5 frames without blocking
+ * @note	The carrier is generated by TIMER2 and gated by the TIMER1 compare
+ *			B interrupt, so MILLIS_COUNT must run TIMER1 (not tickless mode).
+ *			The IR LED is driven from OC2A (PB3) by default. Define
+ *			IR_TX_USE_OC2B to use OC2B (PD3) instead, which is the pin used by
+ *			the receiver in nec_ir.c.
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IR_TX_H_
+#define IR_TX_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <MILLIS_COUNT/millis_count.h>
+
+/* Defines -------------------------------------------------------------------*/
+#ifdef MILLIS_COUNT_TICKLESS
+#error "IR TX need TIMER1 from MILLIS_COUNT, MILLIS_COUNT_TICKLESS can not be used"
+#endif
+
+#ifndef IR_TX_CARRIER_HZ
+#define IR_TX_CARRIER_HZ	38000UL
+#endif
+
+/*
+ * TIMER2 toggles the output in CTC mode so it runs at twice the carrier
+ * frequency. Use the prescaler that lets the period fit in 8 bits.
+ */
+#if (F_CPU / (2 * IR_TX_CARRIER_HZ)) <= 256
+#define IR_TX_CARRIER_PRESCALER	TIMER_PRESCALER_1
+#define IR_TX_CARRIER_TOP		((F_CPU + IR_TX_CARRIER_HZ) / (2 * IR_TX_CARRIER_HZ) - 1)
+#else
+#define IR_TX_CARRIER_PRESCALER	TIMER_PRESCALER_8
+#define IR_TX_CARRIER_TOP		((F_CPU / 8 + IR_TX_CARRIER_HZ) / (2 * IR_TX_CARRIER_HZ) - 1)
+#endif
+
+// Enough for a NEC frame: start, header, 32 bits, stop bit and the gap after it
+#define IR_TX_MAX_EDGES		69
+
+/* Function prototypes -------------------------------------------------------*/
+void IR_TX_Init();
+uint8_t IR_TX_SendNEC(uint16_t Address, uint8_t Command);
+uint8_t IR_TX_SendNECRepeat();
+uint8_t IR_TX_SendRC5(uint8_t Address, uint8_t Command, uint8_t Toggle);
+uint8_t IR_TX_IsBusy();
+
+#endif /* IR_TX_H_ */
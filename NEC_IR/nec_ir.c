@@ -7,153 +7,627 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <atmega328x/uart.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <MILLIS_COUNT/millis_count.h>
 
 #include "nec_ir.h"
 
+#define NEC_IR_QUEUE_MASK	(NEC_IR_QUEUE_SIZE - 1)
+#define NEC_IR_EDGE_MASK	(NEC_IR_EDGE_BUFFER_SIZE - 1)
+
+// Edges are stored as the length in microseconds with the top bit set for a mark
+#define EDGE_MARK			0x8000
+#define EDGE_MAX_DURATION	0x7FFF
+// Spaces longer than micros16() can measure, shorter or longer than the repeat timeout
+#define EDGE_LONG			(EDGE_MAX_DURATION - 1)
+#define EDGE_TIMEOUT		EDGE_MAX_DURATION
+
+// NEC repeat codes are sent every 108 ms while the button is held, allow some slack
+#define NEC_IR_REPEAT_TIMEOUT_MICROS	140000UL
+
+/*
+ * The INT1 ISR can be delayed by other interrupts, this is the number of
+ * clock cycles that is added as an absolute tolerance to every timing
+ */
+#define IR_LATENCY_CYCLES	100
+#define IR_LATENCY_MICROS	((uint16_t)(IR_LATENCY_CYCLES * 1000000UL / F_CPU) + 1)
+
+// Tolerance is given in 1/256 of the nominal length
+#define IR_TOLERANCE(NOMINAL, TOLERANCE)	((uint16_t)(((uint32_t)(NOMINAL) * (TOLERANCE)) >> 8) + IR_LATENCY_MICROS)
+
+// Encodings
+#define IR_PULSE_DISTANCE	0	// Fixed mark, the space length gives the bit (NEC)
+#define IR_PULSE_WIDTH		1	// Fixed space, the mark length gives the bit (SIRC)
+#define IR_BIPHASE			2	// Manchester coded half bits (RC5, RC6)
+
+// Timing flags
+#define IR_LSB_FIRST		0x01
+#define IR_ONE_MARK_FIRST	0x02	// Biphase one is mark then space (RC6), otherwise space then mark (RC5)
+
+#define IR_NO_LONG_BIT		0xFF
+
+/*
+ * Timing of a protocol, all lengths in microseconds. For biphase the
+ * unit is the length of a half bit and bits includes the start bits.
+ */
+typedef struct
+{
+	uint8_t encoding;
+	uint8_t flags;
+	uint8_t minBits;
+	uint8_t maxBits;
+	uint8_t longBit;		// Biphase bit with double length half bits (RC6 trailer bit)
+	uint8_t tolerance;
+	uint16_t headerMark;	// 0 if there is no header
+	uint16_t headerSpace;
+	uint16_t repeatSpace;	// Space after the header mark of a repeat code, 0 if not used
+	uint16_t unit;			// Pulse distance and width: fixed mark/space, biphase: half bit
+	uint16_t zero;			// Pulse distance: zero space, pulse width: zero mark
+	uint16_t one;			// Pulse distance: one space, pulse width: one mark
+} IrTiming;
+
+static const IrTiming _irTimings[NEC_IR_PROTOCOL_COUNT] PROGMEM = {
+	// NEC
+	{IR_PULSE_DISTANCE, IR_LSB_FIRST, 32, 32, IR_NO_LONG_BIT, 64, 9000, 4500, 2250, 560, 560, 1690},
+	// RC5
+	{IR_BIPHASE, 0, 14, 14, IR_NO_LONG_BIT, 64, 0, 0, 0, 889, 0, 0},
+	// RC6 mode 0
+	{IR_BIPHASE, IR_ONE_MARK_FIRST, 21, 21, 4, 80, 2666, 889, 0, 444, 0, 0},
+	// Sony SIRC 12, 15 and 20 bits
+	{IR_PULSE_WIDTH, IR_LSB_FIRST, 12, 20, IR_NO_LONG_BIT, 64, 2400, 600, 0, 600, 600, 1200}
+};
+
+typedef enum
+{
+	STATE_WAIT_GAP,		// Out of sync, waiting for a long space
+	STATE_READY,		// A long space has been seen, next mark can start a frame
+	STATE_HEADER_SPACE,
+	STATE_REPEAT_MARK,
+	STATE_DATA
+} IrState;
+
+typedef struct
+{
+	IrState state;
+	uint8_t bitCount;
+	uint32_t data;
+	uint8_t halfUnits;		// Biphase: units in the current half bit
+	uint8_t halfIsMark;		// Biphase: level of the current half bit
+	uint8_t firstHalf;		// Biphase: 0 if no half bit is waiting, otherwise 1 + level
+} IrDecoder;
+
+static IrDecoder _irDecoders[NEC_IR_PROTOCOL_COUNT];
+static uint8_t _irProtocolMask = NEC_IR_PROTOCOL_ALL;
+
+// Last valid NEC frame and the time since it or its last repeat, used for repeat codes
+static NEC_IR_Frame_TypeDef _irLastNecFrame;
+static uint32_t _irSinceLastNecFrame = NEC_IR_REPEAT_TIMEOUT_MICROS;
+
+// Written by the ISR
+static volatile uint16_t _irEdges[NEC_IR_EDGE_BUFFER_SIZE];
+static volatile uint8_t _irEdgesIn;
+static volatile uint8_t _irEdgesOut;
+static volatile uint8_t _irEdgeOverflow;
+static volatile uint16_t _irLastEdgeMicros;
+static volatile uint16_t _irLastEdgeMillis;
+static volatile uint8_t _irLineIdle = TRUE;
+
+static NEC_IR_Frame_TypeDef _irQueue[NEC_IR_QUEUE_SIZE];
+static uint8_t _irQueueIn;
+static uint8_t _irQueueOut;
+static uint8_t _irErrors;
+
+static void decodePendingEdges();
+static void resetDecoders();
+static void feedDecoder(uint8_t theProtocol, uint8_t theIsMark, uint16_t theDuration);
+static uint8_t feedBiphaseDuration(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theIsMark, uint16_t theDuration);
+static uint8_t feedBiphase(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theIsMark, uint8_t theUnits);
+static uint8_t pushBit(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theBit);
+static void completeFrame(uint8_t theProtocol, IrDecoder* theDecoder);
+static uint8_t buildFrame(uint8_t theProtocol, uint32_t theData, uint8_t theBits, NEC_IR_Frame_TypeDef* theFrame);
+static void queueFrame(NEC_IR_Frame_TypeDef* theFrame);
+static void countError();
+static uint8_t matches(uint16_t theDuration, uint16_t theNominal, uint8_t theTolerance);
+static uint32_t legacyCode(NEC_IR_Frame_TypeDef* theFrame);
+
+/************************************************************************
+	Setup the IR Receiver
+	theManageIrDataFunc is called from NEC_IR_Process() with NEC frames
+	and can be 0 if frames are read with NEC_IR_Read() instead
+************************************************************************/
+void NEC_IR_Init(void(*theManageIrDataFunc)(uint32_t))
+{	
+	_irManageDataFunc = theManageIrDataFunc;
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	resetDecoders();
+	DDRD &= ~_BV(PORTD3);
+	EICRA |= _BV(ISC10);
+	EIMSK |= _BV(INT1);
+	sei();
+}
 
 /************************************************************************
-	Setup the micro counter
+	Select which protocols to decode, a mask of 1 << NEC_IR_PROTOCOL_x
 ************************************************************************/
-static void setupMicroCounter()
+void NEC_IR_EnableProtocols(uint8_t theProtocolMask)
 {
-	/*
-		Prescale = 1;
-		1/(8000000/1) = 0.125 us
-		Count 80 steps = 80*0.125 = 10us
-	*/
-	TCCR2A = _BV(WGM21);
-	OCR2A = 79;
+	_irProtocolMask = theProtocolMask & NEC_IR_PROTOCOL_ALL;
+	resetDecoders();
 }
 
 /************************************************************************
-	Start the micro counter
+	Return the number of decoded frames waiting in the queue
 ************************************************************************/
-static void startMicroCounter()
+uint8_t NEC_IR_Available()
 {
-	TCCR2B = _BV(CS20);
-	TIMSK2 = _BV(OCIE2A);
-	sei();
+	decodePendingEdges();
+	return (_irQueueIn - _irQueueOut) & NEC_IR_QUEUE_MASK;
 }
 
 /************************************************************************
-	Stop the micro counter
+	Read the oldest decoded frame from the queue
+	Returns TRUE if a frame was read and FALSE if the queue is empty
 ************************************************************************/
-static void stopMicroCounter()
+uint8_t NEC_IR_Read(NEC_IR_Frame_TypeDef* theFrame)
 {
-	TCCR2B = 0;
-	_microCount = 0;
-	TIMSK2 = 0;
+	decodePendingEdges();
+	if (_irQueueOut == _irQueueIn) return FALSE;
+	
+	*theFrame = _irQueue[_irQueueOut];
+	_irQueueOut = (_irQueueOut + 1) & NEC_IR_QUEUE_MASK;
+	return TRUE;
 }
+
 /************************************************************************
-	Interrupt routine for Timer 2 compare A match
+	Call from the main loop, at least every 30 ms while IR is received.
+	Decodes the stored marks and spaces and passes NEC frames to the
+	function given to NEC_IR_Init(). Repeat codes and other protocols
+	are skipped and the data has the same format as before so existing
+	handlers keep working.
 ************************************************************************/
-ISR(TIMER2_COMPA_vect)
+void NEC_IR_Process()
 {
-	// Will overflow after approx 71.58 minutes
-	_microCount += 10;
+	NEC_IR_Frame_TypeDef frame;
+	while (NEC_IR_Read(&frame))
+	{
+		if (_irManageDataFunc && frame.protocol == NEC_IR_PROTOCOL_NEC && 
+			!(frame.flags & NEC_IR_FLAG_REPEAT))
+			_irManageDataFunc(legacyCode(&frame));
+	}
 }
 
 /************************************************************************
-	Setup the IR Receiver
+	Return the number of frames that were dropped because they did not
+	validate, the edge buffer overflowed or the queue was full.
+	Saturates at 255.
 ************************************************************************/
-void NEC_IR_Init(void(*theManageIrDataFunc)(uint32_t))
-{	
-	_irManageDataFunc = theManageIrDataFunc;
-	setupMicroCounter();
-	DDRD &= ~_BV(PORTD3);
-	EICRA |= _BV(ISC10);
-	EIMSK |= _BV(INT1);
-	sei();
+uint8_t NEC_IR_Errors()
+{
+	return _irErrors;
+}
+
+/************************************************************************
+	Run the stored marks and spaces through the decoders. When the line
+	has been quiet for NEC_IR_GAP_MICROS a gap is fed so the last frame
+	is finished without waiting for the next one.
+************************************************************************/
+static void decodePendingEdges()
+{
+	if (_irEdgeOverflow)
+	{
+		_irEdgeOverflow = FALSE;
+		_irEdgesOut = _irEdgesIn;
+		resetDecoders();
+		countError();
+	}
+	
+	while (_irEdgesOut != _irEdgesIn)
+	{
+		uint16_t edge = _irEdges[_irEdgesOut];
+		_irEdgesOut = (_irEdgesOut + 1) & NEC_IR_EDGE_MASK;
+		
+		uint8_t isMark = (edge & EDGE_MARK) != 0;
+		uint16_t duration = edge & EDGE_MAX_DURATION;
+		for (uint8_t i = 0; i < NEC_IR_PROTOCOL_COUNT; ++i)
+			feedDecoder(i, isMark, duration);
+		
+		if (duration == EDGE_TIMEOUT)
+			_irSinceLastNecFrame = NEC_IR_REPEAT_TIMEOUT_MICROS;
+		else if (_irSinceLastNecFrame < NEC_IR_REPEAT_TIMEOUT_MICROS)
+			_irSinceLastNecFrame += duration;
+	}
+	
+	uint8_t gap = FALSE;
+	uint8_t timeout = FALSE;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!_irLineIdle && _irEdgesOut == _irEdgesIn && (PIND & _BV(PORTD3)) &&
+			(uint16_t)(micros16() - _irLastEdgeMicros) >= NEC_IR_GAP_MICROS)
+		{
+			_irLineIdle = TRUE;
+			gap = TRUE;
+		}
+		
+		// The gap is only a few ms, a repeat code is too late once the line has been idle this long
+		if (_irLineIdle && _irEdgesOut == _irEdgesIn &&
+			(uint16_t)(millis16bit() - _irLastEdgeMillis) >= NEC_IR_REPEAT_TIMEOUT_MICROS / 1000)
+			timeout = TRUE;
+	}
+	if (timeout)
+		_irSinceLastNecFrame = NEC_IR_REPEAT_TIMEOUT_MICROS;
+	if (gap)
+	{
+		for (uint8_t i = 0; i < NEC_IR_PROTOCOL_COUNT; ++i)
+			feedDecoder(i, FALSE, NEC_IR_GAP_MICROS);
+	}
+}
+
+/************************************************************************
+	Put all decoders out of sync until the next gap
+************************************************************************/
+static void resetDecoders()
+{
+	for (uint8_t i = 0; i < NEC_IR_PROTOCOL_COUNT; ++i)
+		_irDecoders[i].state = STATE_WAIT_GAP;
+}
+
+/************************************************************************
+	Feed one mark or space to the decoder for a protocol
+************************************************************************/
+static void feedDecoder(uint8_t theProtocol, uint8_t theIsMark, uint16_t theDuration)
+{
+	if (!(_irProtocolMask & (1 << theProtocol))) return;
+	
+	IrDecoder* decoder = &_irDecoders[theProtocol];
+	IrTiming timing;
+	memcpy_P(&timing, &_irTimings[theProtocol], sizeof(IrTiming));
+	
+	// A long space ends the frame and the next mark can start a new one
+	if (!theIsMark && theDuration >= NEC_IR_GAP_MICROS)
+	{
+		if (decoder->state == STATE_DATA)
+		{
+			// The last half bit of a biphase frame can be a space that is part of the gap
+			if (timing.encoding == IR_BIPHASE && decoder->firstHalf == 2 &&
+				decoder->bitCount == timing.maxBits - 1)
+				pushBit(decoder, &timing, (timing.flags & IR_ONE_MARK_FIRST) != 0);
+			
+			if (decoder->bitCount >= timing.minBits)
+				completeFrame(theProtocol, decoder);
+		}
+		decoder->state = STATE_READY;
+		return;
+	}
+	
+	uint8_t error = FALSE;
+	switch (decoder->state)
+	{
+	case STATE_WAIT_GAP:
+		break;
+	
+	case STATE_READY:
+		decoder->bitCount = 0;
+		decoder->data = 0;
+		decoder->halfUnits = 0;
+		decoder->firstHalf = 0;
+		if (timing.headerMark)
+		{
+			if (theIsMark && matches(theDuration, timing.headerMark, timing.tolerance))
+				decoder->state = STATE_HEADER_SPACE;
+			else
+				error = TRUE;
+		}
+		else
+		{
+			// Without a header the first half bit is a space that is part of the gap
+			decoder->state = STATE_DATA;
+			error = !theIsMark || feedBiphase(decoder, &timing, FALSE, 1) ||
+					feedBiphaseDuration(decoder, &timing, TRUE, theDuration);
+		}
+		break;
+	
+	case STATE_HEADER_SPACE:
+		if (matches(theDuration, timing.headerSpace, timing.tolerance))
+			decoder->state = STATE_DATA;
+		else if (timing.repeatSpace && matches(theDuration, timing.repeatSpace, timing.tolerance))
+			decoder->state = STATE_REPEAT_MARK;
+		else
+			error = TRUE;
+		break;
+	
+	case STATE_REPEAT_MARK:
+		if (matches(theDuration, timing.unit, timing.tolerance) &&
+			_irSinceLastNecFrame < NEC_IR_REPEAT_TIMEOUT_MICROS)
+		{
+			NEC_IR_Frame_TypeDef frame = _irLastNecFrame;
+			frame.flags |= NEC_IR_FLAG_REPEAT;
+			queueFrame(&frame);
+			_irSinceLastNecFrame = 0;
+		}
+		decoder->state = STATE_WAIT_GAP;
+		break;
+	
+	case STATE_DATA:
+		if (timing.encoding == IR_BIPHASE)
+		{
+			error = feedBiphaseDuration(decoder, &timing, theIsMark, theDuration);
+		}
+		else if (timing.encoding == IR_PULSE_DISTANCE)
+		{
+			if (theIsMark)
+			{
+				if (!matches(theDuration, timing.unit, timing.tolerance))
+					error = TRUE;
+				// The mark after the last bit is the stop bit
+				else if (decoder->bitCount == timing.maxBits)
+					completeFrame(theProtocol, decoder);
+			}
+			else if (matches(theDuration, timing.zero, timing.tolerance))
+				error = pushBit(decoder, &timing, 0);
+			else if (matches(theDuration, timing.one, timing.tolerance))
+				error = pushBit(decoder, &timing, 1);
+			else
+				error = TRUE;
+		}
+		else
+		{
+			if (!theIsMark)
+				error = !matches(theDuration, timing.unit, timing.tolerance);
+			else if (matches(theDuration, timing.zero, timing.tolerance))
+				error = pushBit(decoder, &timing, 0);
+			else if (matches(theDuration, timing.one, timing.tolerance))
+				error = pushBit(decoder, &timing, 1);
+			else
+				error = TRUE;
+		}
+		
+		if (decoder->state == STATE_DATA && timing.encoding != IR_PULSE_DISTANCE && 
+			decoder->bitCount == timing.maxBits)
+			completeFrame(theProtocol, decoder);
+		break;
+	}
+	
+	if (error) decoder->state = STATE_WAIT_GAP;
+}
+
+/************************************************************************
+	Round a mark or space to a whole number of biphase units and feed it.
+	Returns TRUE on error.
+************************************************************************/
+static uint8_t feedBiphaseDuration(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theIsMark, uint16_t theDuration)
+{
+	// One unit, or up to three next to the double length bit of RC6
+	uint8_t units = (theDuration + theTiming->unit / 2) / theTiming->unit;
+	if (units == 0 || units > 3 || 
+		!matches(theDuration, units * theTiming->unit, theTiming->tolerance))
+		return TRUE;
+	return feedBiphase(theDecoder, theTiming, theIsMark, units);
+}
+
+/************************************************************************
+	Feed a number of biphase units with the same level. Two half bits
+	with different levels make one bit. Returns TRUE on error.
+************************************************************************/
+static uint8_t feedBiphase(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theIsMark, uint8_t theUnits)
+{
+	while (theUnits--)
+	{
+		uint8_t halfLength = (theDecoder->bitCount == theTiming->longBit) ? 2 : 1;
+		
+		if (theDecoder->halfUnits == 0)
+			theDecoder->halfIsMark = theIsMark;
+		else if (theDecoder->halfIsMark != theIsMark)
+			return TRUE;
+		
+		if (++theDecoder->halfUnits < halfLength) continue;
+		theDecoder->halfUnits = 0;
+		
+		if (!theDecoder->firstHalf)
+		{
+			theDecoder->firstHalf = 1 + theIsMark;
+		}
+		else
+		{
+			// No level change in the middle of the bit
+			if (theDecoder->firstHalf == 1 + theIsMark) return TRUE;
+			uint8_t firstIsMark = theDecoder->firstHalf - 1;
+			theDecoder->firstHalf = 0;
+			if (pushBit(theDecoder, theTiming, firstIsMark == ((theTiming->flags & IR_ONE_MARK_FIRST) != 0)))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/************************************************************************
+	Add a bit to the received data. Returns TRUE if there are too many.
+************************************************************************/
+static uint8_t pushBit(IrDecoder* theDecoder, const IrTiming* theTiming, uint8_t theBit)
+{
+	if (theDecoder->bitCount >= theTiming->maxBits) return TRUE;
+	
+	if (theTiming->flags & IR_LSB_FIRST)
+	{
+		if (theBit) theDecoder->data |= (uint32_t)1 << theDecoder->bitCount;
+	}
+	else
+		theDecoder->data = (theDecoder->data << 1) | theBit;
+	
+	++theDecoder->bitCount;
+	return FALSE;
+}
+
+/************************************************************************
+	Validate and queue a frame when all bits have been received
+************************************************************************/
+static void completeFrame(uint8_t theProtocol, IrDecoder* theDecoder)
+{
+	NEC_IR_Frame_TypeDef frame;
+	if (buildFrame(theProtocol, theDecoder->data, theDecoder->bitCount, &frame))
+	{
+		queueFrame(&frame);
+		if (theProtocol == NEC_IR_PROTOCOL_NEC)
+		{
+			_irLastNecFrame = frame;
+			_irSinceLastNecFrame = 0;
+		}
+	}
+	else
+		countError();
+	theDecoder->state = STATE_WAIT_GAP;
+}
+
+/************************************************************************
+	Split the received bits into address and command
+	Returns TRUE if the frame is valid
+************************************************************************/
+static uint8_t buildFrame(uint8_t theProtocol, uint32_t theData, uint8_t theBits, NEC_IR_Frame_TypeDef* theFrame)
+{
+	theFrame->protocol = theProtocol;
+	theFrame->flags = 0;
+	
+	switch (theProtocol)
+	{
+	case NEC_IR_PROTOCOL_NEC:
+	{
+		// Address, address or ~address, command, ~command
+		uint8_t addressLow = theData & 0xFF;
+		uint8_t addressHigh = (theData >> 8) & 0xFF;
+		uint8_t command = (theData >> 16) & 0xFF;
+		if ((command ^ (uint8_t)(theData >> 24)) != 0xFF) return FALSE;
+		
+		theFrame->command = command;
+		if ((addressLow ^ addressHigh) == 0xFF)
+			theFrame->address = addressLow;
+		else
+		{
+			theFrame->address = ((uint16_t)addressHigh << 8) | addressLow;
+			theFrame->flags = NEC_IR_FLAG_EXTENDED;
+		}
+		return TRUE;
+	}
+	
+	case NEC_IR_PROTOCOL_RC5:
+		// Start bit, inverted command bit 6, toggle, 5 bits address, 6 bits command
+		if (!(theData & 0x2000)) return FALSE;
+		theFrame->address = (theData >> 6) & 0x1F;
+		theFrame->command = theData & 0x3F;
+		if (!(theData & 0x1000))
+		{
+			theFrame->command |= 0x40;
+			theFrame->flags |= NEC_IR_FLAG_EXTENDED;
+		}
+		if (theData & 0x0800) theFrame->flags |= NEC_IR_FLAG_TOGGLE;
+		return TRUE;
+	
+	case NEC_IR_PROTOCOL_RC6:
+		// Start bit, 3 bits mode, toggle, 8 bits address, 8 bits command
+		if ((theData >> 17) != 0x08) return FALSE;
+		theFrame->address = (theData >> 8) & 0xFF;
+		theFrame->command = theData & 0xFF;
+		if (theData & 0x10000) theFrame->flags |= NEC_IR_FLAG_TOGGLE;
+		return TRUE;
+	
+	case NEC_IR_PROTOCOL_SIRC:
+		// 7 bits command followed by 5, 8 or 5 + 8 bits address
+		if (theBits != 12 && theBits != 15 && theBits != 20) return FALSE;
+		theFrame->command = theData & 0x7F;
+		theFrame->address = theData >> 7;
+		if (theBits == 20) theFrame->flags |= NEC_IR_FLAG_EXTENDED;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/************************************************************************
+	Put a frame in the queue
+************************************************************************/
+static void queueFrame(NEC_IR_Frame_TypeDef* theFrame)
+{
+	uint8_t next = (_irQueueIn + 1) & NEC_IR_QUEUE_MASK;
+	if (next != _irQueueOut)
+	{
+		_irQueue[_irQueueIn] = *theFrame;
+		_irQueueIn = next;
+	}
+	else
+		countError();
+}
+
+/************************************************************************
+	Count a dropped frame
+************************************************************************/
+static void countError()
+{
+	if (_irErrors != 0xFF) ++_irErrors;
+}
+
+/************************************************************************
+	Check if a duration is within the tolerance of a nominal length
+************************************************************************/
+static uint8_t matches(uint16_t theDuration, uint16_t theNominal, uint8_t theTolerance)
+{
+	uint16_t tolerance = IR_TOLERANCE(theNominal, theTolerance);
+	return (theDuration + tolerance >= theNominal) && (theDuration <= theNominal + tolerance);
+}
+
+/************************************************************************
+	Rebuild the 32-bit value the old decoder passed to _irManageDataFunc,
+	which had the order of the nibbles reversed
+************************************************************************/
+static uint32_t legacyCode(NEC_IR_Frame_TypeDef* theFrame)
+{
+	uint8_t addressHigh = (theFrame->flags & NEC_IR_FLAG_EXTENDED) ?
+							(theFrame->address >> 8) : ~theFrame->address;
+	uint32_t data = (uint32_t)(theFrame->address & 0xFF) | 
+					((uint32_t)addressHigh << 8) | 
+					((uint32_t)theFrame->command << 16) | 
+					((uint32_t)(uint8_t)~theFrame->command << 24);
+	
+	uint32_t code = 0;
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		code |= (data & 0xF) << 4*(7-i);
+		data = data >> 4;
+	}
+	return code;
 }
 
 /************************************************************************
 	Interrupt routine for external intterupt 1 (IR Receiver)
+	Stores the length of the mark or space that just ended. The receiver
+	output is low while a carrier is detected.
 ************************************************************************/
 ISR(INT1_vect)
 {
-	uint8_t logicLevel = PIND & _BV(PORTD3);
-	if (logicLevel) logicLevel = LOW;
-	else logicLevel = HIGH;
-	
-	static uint8_t bitCount = 0;
-	static uint32_t irData = 0;
-	static uint8_t start = TRUE;
-		
-	// Change to high:
-	if (logicLevel == HIGH)
-	{
-		// Check for second low level startbit
-		if (start && _microCount > 4400 && _microCount < 4600)
-		{
-			start = FALSE;
-			_microCount = 0;
-		}
-		// Check for first startbit
-		else if (start)
-		{
-			startMicroCounter();
-		}			
-		// Done with collecting all 32 bits
-		else if (bitCount == 32)
-		{
-			static uint32_t irDataCorrectEndian = 0;
-			irDataCorrectEndian = 0;
-			for (uint8_t i = 0; i < 8; ++i)
-			{
-				irDataCorrectEndian |= (irData & 0xF) << 4*(7-i);
-				irData = irData >> 4;
-			}
-			irData = irDataCorrectEndian;
-			
-			if (_irManageDataFunc) _irManageDataFunc(irDataCorrectEndian);
-			/*
-			UART_Write((irData >> 24) & 0xFF);	
-			UART_Write((irData >> 16) & 0xFF);
-			UART_Write((irData >> 8) & 0xFF);
-			UART_Write(irData & 0xFF);
-			*/
-			
-			bitCount = irData = 0;
-			start = TRUE;
-			stopMicroCounter();
-		}
-		else
-		{
-			if (_microCount > 460 && _microCount < 660)
-			{
-				++bitCount;
-				irData = (irData >> 1);
-				_microCount = 0;
-			}
-			else if (_microCount > 1590 && _microCount < 1790)
-			{
-				++bitCount;
-				irData = (irData >> 1) | 0x80000000;
-				_microCount = 0;
-			}
-			else
-			{
-				bitCount = irData = 0;
-				start = TRUE;
-				stopMicroCounter();
-			}
-		}
-		
-	}
-	//Change to low:
-	else
-	{
-		if (start && _microCount > 8850 && _microCount < 9150)
-			_microCount = 0;
-		else if (start)
-			stopMicroCounter();
-		else if (_microCount > 460 && _microCount < 660)
-			_microCount = 0;
-		else
-		{
-			start = TRUE;
-			stopMicroCounter();
-		}
-	}
-}
\ No newline at end of file
+	uint16_t now = micros16();
+	uint16_t nowMillis = millis16bit();
+	uint16_t duration = now - _irLastEdgeMicros;
+	_irLastEdgeMicros = now;
+	
+	// micros16() wraps every 65 ms so a long idle time is flagged by NEC_IR_Process()
+	if (_irLineIdle || duration > EDGE_LONG)
+	{
+		if ((uint16_t)(nowMillis - _irLastEdgeMillis) >= NEC_IR_REPEAT_TIMEOUT_MICROS / 1000)
+			duration = EDGE_TIMEOUT;
+		else
+			duration = EDGE_LONG;
+	}
+	_irLastEdgeMillis = nowMillis;
+	_irLineIdle = FALSE;
+	
+	// A mark has just ended when the receiver output goes high
+	if (PIND & _BV(PORTD3))
+		duration |= EDGE_MARK;
+	
+	uint8_t next = (_irEdgesIn + 1) & NEC_IR_EDGE_MASK;
+	if (next != _irEdgesOut)
+	{
+		_irEdges[_irEdgesIn] = duration;
+		_irEdgesIn = next;
+	}
+	else
+		_irEdgeOverflow = TRUE;
+}
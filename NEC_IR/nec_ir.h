@@ -3,33 +3,92 @@
  *
  * Created: 2012-10-24 19:23:03
  *  Author: Hampus
+ *
+ * IR receiver for NEC, RC5, RC6 (mode 0) and Sony SIRC remotes.
+ * The ISR only stores the length of each mark and space, the frames are
+ * decoded in NEC_IR_Process() against the timing tables in nec_ir.c.
  */ 
 
 #ifndef NEC_IR_H
 #define NEC_IR_H
 
-// Uses TIMER2, and INT1
-#if defined(INT1_IN_USE) || defined(TIMER2_IN_USE)
-#error "NEC IR need INT1 and TIMER2. Used somewhere else"
+#include <stdint.h>
+
+// Uses INT1, pulses are timed with micros16() from MILLIS_COUNT (TIMER1)
+#if defined(INT1_IN_USE)
+#error "NEC IR need INT1. Used somewhere else"
 #else
 #define INT1_IN_USE
-#define TIMER2_IN_USE
+#endif
+
+#ifdef MILLIS_COUNT_TICKLESS
+#error "NEC IR need microsecond resolution, MILLIS_COUNT_TICKLESS can not be used"
 #endif
 
 
 #ifndef HELP_DEFINITIONS
 #define HELP_DEFINITIONS
-#define TRUE	1
-#define FALSE	0
-#define HIGH	1
+#define TRUE	1
+#define FALSE	0
+#define HIGH	1
 #define LOW		0
 #endif
 
-volatile uint32_t _microCount;
+// Number of decoded frames that can wait for NEC_IR_Read, must be a power of 2
+#ifndef NEC_IR_QUEUE_SIZE
+#define NEC_IR_QUEUE_SIZE	4
+#endif
+
+#if (NEC_IR_QUEUE_SIZE & (NEC_IR_QUEUE_SIZE - 1)) != 0
+#error "NEC_IR_QUEUE_SIZE must be a power of 2"
+#endif
+
+// Number of marks and spaces the ISR can store before NEC_IR_Process() has
+// to run, must be a power of 2. 64 is about 35 ms of NEC data.
+#ifndef NEC_IR_EDGE_BUFFER_SIZE
+#define NEC_IR_EDGE_BUFFER_SIZE	64
+#endif
+
+#if (NEC_IR_EDGE_BUFFER_SIZE & (NEC_IR_EDGE_BUFFER_SIZE - 1)) != 0 || NEC_IR_EDGE_BUFFER_SIZE > 128
+#error "NEC_IR_EDGE_BUFFER_SIZE must be a power of 2 and at most 128"
+#endif
+
+// A space this long in microseconds ends a frame
+#ifndef NEC_IR_GAP_MICROS
+#define NEC_IR_GAP_MICROS	6000
+#endif
+
+// Protocols
+#define NEC_IR_PROTOCOL_NEC		0
+#define NEC_IR_PROTOCOL_RC5		1
+#define NEC_IR_PROTOCOL_RC6		2
+#define NEC_IR_PROTOCOL_SIRC	3
+#define NEC_IR_PROTOCOL_COUNT	4
+
+#define NEC_IR_PROTOCOL_ALL		((1 << NEC_IR_PROTOCOL_COUNT) - 1)
+
+// Frame flags
+#define NEC_IR_FLAG_REPEAT		0x01	// NEC repeat code, address and command are from the last frame
+#define NEC_IR_FLAG_EXTENDED	0x02	// NEC 16-bit address, RC5 extended command or SIRC 20-bit frame
+#define NEC_IR_FLAG_TOGGLE		0x04	// Toggle bit of RC5 and RC6, changes for every new button press
+
+// A decoded frame
+typedef struct
+{
+	uint8_t protocol;
+	uint8_t flags;
+	uint16_t address;
+	uint8_t command;
+} NEC_IR_Frame_TypeDef;
 
 // Pointer to a function that handles received IR data
 void (*_irManageDataFunc)(uint32_t);
 
 void NEC_IR_Init(void(*theIrManageDataFunc)(uint32_t));
+void NEC_IR_EnableProtocols(uint8_t theProtocolMask);
+uint8_t NEC_IR_Available();
+uint8_t NEC_IR_Read(NEC_IR_Frame_TypeDef* theFrame);
+void NEC_IR_Process();
+uint8_t NEC_IR_Errors();
 
-#endif
\ No newline at end of file
+#endif
@@ -8,181 +8,434 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <atmega328x/twi.h>
-#include <COLOR_8_BIT/color_8_bit.h>
+#include <COLOR/color.h>
+#include <assert/assert.h>
 
 #include "PCA9633.h"
 
+#define MODE1_SLEEP		4
+#define MODE1_ALLCALL	0
+// AI2:AI0 are read-only and show the auto increment bits of the control byte
+#define MODE1_WRITABLE	0x1F
+#define MODE2_DMBLNK	5
+#define MODE2_INVRT		4
+#define MODE2_OUTNE		0x03
+
+// PINx, DDRx and PORTx of a port are next to each other
+#define OE_DDR(DEVICE)	(*((DEVICE)->oePort - 1))
+#define OE_PINX(DEVICE)	(*((DEVICE)->oePort - 2))
+
+// Outputs in LEDOUT that are set to PCA9633_LEDOUT_PWM (10b) and PCA9633_LEDOUT_PWM_AND_GROUP (11b)
+#define LEDOUT_PWM(VALUE)	(((VALUE) & 0xAA) & ~(((VALUE) & 0x55) << 1))
+#define LEDOUT_GROUP(VALUE)	(((VALUE) & 0xAA) & (((VALUE) & 0x55) << 1))
+
+PCA9633_Device_TypeDef _pca9633Default = {PCA9633_ADDRESS, &PCA9633_OE_PORT, PCA9633_OE, {0}, 0, 0, 0};
+
 /************************************************************************
 	"Private" functions
  ***********************************************************************/
-static void setRegister(const uint8_t registerToSet, const uint8_t value)
+/*
+	Returns the copy of a register. A broadcast device uses its first
+	member.
+*/
+static uint8_t getRegister(const PCA9633_Device_TypeDef* device, const uint8_t registerToGet)
+{
+	if (device->members)
+		return device->members[0]->registers[registerToGet];
+	return device->registers[registerToGet];
+}
+
+/*
+	Returns the copy of a register that is changed and written back. The
+	write goes to every member of a broadcast device, so they must all
+	have the same value or they would get the one of the first member.
+*/
+static uint8_t getSharedRegister(const PCA9633_Device_TypeDef* device, const uint8_t registerToGet)
 {
-	if (registerToSet < PCA9633_REGISTER_COUNT)
+	uint8_t value = getRegister(device, registerToGet);
+	for (uint8_t member = 1; member < device->numOfMembers; member++)
+		assert_param(device->members[member]->registers[registerToGet] == value);
+	return value;
+}
+
+/*
+	Checks if the PCA9633 has another value in a register, for a broadcast
+	device if any of the members has
+*/
+static uint8_t registerDiffers(const PCA9633_Device_TypeDef* device, const uint8_t registerToCheck, const uint8_t value)
+{
+	if (!device->members)
+		return device->registers[registerToCheck] != value;
+	
+	for (uint8_t member = 0; member < device->numOfMembers; member++)
 	{
-		TWI_BeginTransmission(PCA9633_ADDRESS);
-		TWI_Write(PCA9633_AUTO_INC_NO | registerToSet);
-		TWI_Write(value);
-		TWI_EndTransmission();
+		if (device->members[member]->registers[registerToCheck] != value) return 1;
 	}
+	return 0;
 }
 
-static uint8_t activateRegister(const uint8_t registerToActivate)
+/*
+	Writes count registers in a row, starting at firstRegister. Nothing is
+	written if the PCA9633, or every member of a broadcast device, already
+	has the values.
+*/
+static void setRegisters(PCA9633_Device_TypeDef* device, const uint8_t firstRegister, const uint8_t* values, const uint8_t count)
 {
-	if (registerToActivate < PCA9633_REGISTER_COUNT)
+	if (firstRegister + count > PCA9633_REGISTER_COUNT)
+		return;
+	
+	uint8_t changed = 0;
+	for (uint8_t i = 0; i < count; i++)
 	{
-		TWI_BeginTransmission(PCA9633_ADDRESS);
-		TWI_Write(PCA9633_AUTO_INC_NO | registerToActivate);
-		TWI_EndTransmission();
-		return 1;
+		if (registerDiffers(device, firstRegister + i, values[i])) changed = 1;
 	}
-	return 0;
+	if (!changed && (device->members || device->registersValid))
+		return;
+	
+	TWI_BeginTransmission(device->address);
+	TWI_Write(((count > 1) ? PCA9633_AUTO_INC_ALL : PCA9633_AUTO_INC_NO) | firstRegister);
+	for (uint8_t i = 0; i < count; i++)
+		TWI_Write(values[i]);
+	TWI_EndTransmission();
+	
+	for (uint8_t i = 0; i < count; i++)
+	{
+		device->registers[firstRegister + i] = values[i];
+		for (uint8_t member = 0; member < device->numOfMembers; member++)
+			device->members[member]->registers[firstRegister + i] = values[i];
+	}
+}
+
+static void setRegister(PCA9633_Device_TypeDef* device, const uint8_t registerToSet, const uint8_t value)
+{
+	setRegisters(device, registerToSet, &value, 1);
+}
+
+static uint8_t readAllRegisters(PCA9633_Device_TypeDef* device, uint8_t* storage)
+{
+	// The broadcast addresses can't be read
+	if (device->members)
+		return 0;
+	
+	TWI_BeginTransmission(device->address);
+	TWI_Write(PCA9633_AUTO_INC_ALL | PCA9633_MODE1);
+	TWI_EndTransmission();
+	
+	if (TWI_RequestFrom(device->address, storage, PCA9633_REGISTER_COUNT) != 1)
+		return 0;
+	
+	storage[PCA9633_MODE1] &= MODE1_WRITABLE;
+	return 1;
 }
 
 /************************************************************************
-	"Public" functions
+	PCA9633 Device
  ***********************************************************************/
-void pca9633setup()
+/*
+	Initializes a PCA9633 at address with OE on pin of oePort, oePort can
+	be 0 if OE is tied low. The outputs are set to PWM and OE is left high.
+	Returns 1 if the PCA9633 answered.
+*/
+uint8_t PCA9633_Init(PCA9633_Device_TypeDef* Device, uint8_t Address, volatile uint8_t* OePort, uint8_t OePin)
 {
-	static uint8_t setupDone = 0;
-	if (!setupDone)
+	Device->address = Address;
+	Device->oePort = OePort;
+	Device->oePin = OePin;
+	Device->members = 0;
+	Device->numOfMembers = 0;
+	
+	if (OePort)
 	{
-		PCA9633_OE_DDR |= _BV(PCA9633_OE);
-		pca9633outputOff();
-		
-		if (!TWI_Initialized())
-		{
-			TWI_Init_TypeDef twiInit;
-			twiInit.TWI_Frequency = 400000;
-			twiInit.TWI_Mode = TWI_MODE_MASTER;
-			twiInit.TWI_Prescaler = TWI_PRESCALER_1;
-			TWI_Init(&twiInit);
-		}
-		
-		pca9633setLedoutRegister(PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM);
-		setupDone = 1;
+		OE_DDR(Device) |= _BV(OePin);
+		PCA9633_OutputOff(Device);
+	}
+	
+	if (!TWI_Initialized())
+	{
+		TWI_Init_TypeDef twiInit;
+		twiInit.TWI_Frequency = 400000;
+		twiInit.TWI_Mode = TWI_MODE_MASTER;
+		twiInit.TWI_Prescaler = TWI_PRESCALER_1;
+		TWI_Init(&twiInit);
 	}
+	
+	uint8_t status = PCA9633_SyncRegisters(Device);
+	// Normal mode
+	setRegister(Device, PCA9633_MODE1, 0x00);
+	PCA9633_SetLedout(Device, PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM, PCA9633_LEDOUT_PWM);
+	return status;
 }
 
-void pca9633setOutput(const uint8_t output, const uint8_t value)
+/*
+	Initializes a device that writes to all members at once on a broadcast
+	address, the All Call address or a subaddress they have been given with
+	PCA9633_SetAllCallAddress or PCA9633_SetSubAddress. Members must list at
+	least one device and their register copies are updated by every write.
+	Functions that change part of a register, like sleep, invert and the
+	group functions, need the members to have the same value in it.
+*/
+void PCA9633_InitBroadcast(PCA9633_Device_TypeDef* Device, uint8_t Address,
+						PCA9633_Device_TypeDef* const* Members, uint8_t NumOfMembers)
 {
-	if (output < 4)
-		setRegister(output + 2, value);
+	Device->address = Address;
+	Device->oePort = 0;
+	Device->oePin = 0;
+	Device->registersValid = 0;
+	Device->members = Members;
+	Device->numOfMembers = NumOfMembers;
 }
 
-void pca9633setAllOutputs(const uint8_t value0, const uint8_t value1, const uint8_t value2, const uint8_t value3)
+void PCA9633_SetOutput(PCA9633_Device_TypeDef* Device, uint8_t Output, uint8_t Value)
 {
-	TWI_BeginTransmission(PCA9633_ADDRESS);
-	TWI_Write(PCA9633_AUTO_INC_PWM | PCA9633_PWM0);
-	TWI_Write(value0);
-	TWI_Write(value1);
-	TWI_Write(value2);
-	TWI_Write(value3);
-	TWI_EndTransmission();
+	if (Output < 4)
+		setRegister(Device, PCA9633_PWM0 + Output, Value);
 }
 
-void pca9633outputOff() { PCA9633_OE_PORT |= _BV(PCA9633_OE); }
-void pca9633outputOn() { PCA9633_OE_PORT &= ~_BV(PCA9633_OE); }
-uint8_t pca9633outputIsOn() { return !(PCA9633_OE_PINX & _BV(PCA9633_OE)); }
-
-rgba8 pca9633getRgba()
+void PCA9633_SetAllOutputs(PCA9633_Device_TypeDef* Device, uint8_t Value0, uint8_t Value1, uint8_t Value2, uint8_t Value3)
 {
-	TWI_BeginTransmission(PCA9633_ADDRESS);
-	TWI_Write(PCA9633_AUTO_INC_PWM | PCA9633_PWM0);
-	TWI_EndTransmission();
+	uint8_t values[4] = {Value0, Value1, Value2, Value3};
+	setRegisters(Device, PCA9633_PWM0, values, 4);
+}
 
-	uint8_t storage[4];
-	TWI_RequestFrom(PCA9633_ADDRESS, storage, 4);
-	rgba8 colors = {storage[0], storage[1], storage[2], storage[3]};
+rgba8 PCA9633_GetRgba(PCA9633_Device_TypeDef* Device)
+{
+	rgba8 colors = {getRegister(Device, PCA9633_PWM0), getRegister(Device, PCA9633_PWM1),
+					getRegister(Device, PCA9633_PWM2), getRegister(Device, PCA9633_PWM3)};
 	return colors;
 }
 
+void PCA9633_OutputOff(PCA9633_Device_TypeDef* Device)
+{
+	if (Device->oePort) *Device->oePort |= _BV(Device->oePin);
+}
+
+void PCA9633_OutputOn(PCA9633_Device_TypeDef* Device)
+{
+	if (Device->oePort) *Device->oePort &= ~_BV(Device->oePin);
+}
+
+uint8_t PCA9633_OutputIsOn(PCA9633_Device_TypeDef* Device)
+{
+	if (!Device->oePort) return 1;
+	return !(OE_PINX(Device) & _BV(Device->oePin));
+}
 
+uint8_t PCA9633_SyncRegisters(PCA9633_Device_TypeDef* Device)
+{
+	Device->registersValid = readAllRegisters(Device, Device->registers);
+	return Device->registersValid;
+}
+
+/*
+	Returns 1 if the PCA9633 has the same values as the copy. The copy is
+	updated from the PCA9633 either way.
+*/
+uint8_t PCA9633_VerifyRegisters(PCA9633_Device_TypeDef* Device)
+{
+	uint8_t storage[PCA9633_REGISTER_COUNT];
+	if (!readAllRegisters(Device, storage))
+	{
+		Device->registersValid = 0;
+		return 0;
+	}
+	
+	uint8_t match = Device->registersValid;
+	for (uint8_t i = 0; i < PCA9633_REGISTER_COUNT; i++)
+	{
+		if (Device->registers[i] != storage[i]) match = 0;
+		Device->registers[i] = storage[i];
+	}
+	Device->registersValid = 1;
+	return match;
+}
 
 /************************************************************************
 	PCA9633 Sleep
  ***********************************************************************/
-void pca9633goToSleep()
+void PCA9633_Sleep(PCA9633_Device_TypeDef* Device)
 {
-	uint8_t mode1Value;
-	if (activateRegister(PCA9633_MODE1) && TWI_RequestFrom(PCA9633_ADDRESS, &mode1Value, 1))
-	{		
-		mode1Value |= _BV(4);
-		setRegister(PCA9633_MODE1, mode1Value);
-	}
+	setRegister(Device, PCA9633_MODE1, getSharedRegister(Device, PCA9633_MODE1) | _BV(MODE1_SLEEP));
+}
+
+void PCA9633_Wake(PCA9633_Device_TypeDef* Device)
+{
+	setRegister(Device, PCA9633_MODE1, getSharedRegister(Device, PCA9633_MODE1) & ~_BV(MODE1_SLEEP));
+}
+
+uint8_t PCA9633_IsSleeping(PCA9633_Device_TypeDef* Device)
+{
+	if (!Device->registersValid)
+		return 2;
+	
+	return Device->registers[PCA9633_MODE1] & _BV(MODE1_SLEEP);
+}
+
+/************************************************************************
+	PCA9633 Configuration
+ ***********************************************************************/
+void PCA9633_SetLedout(PCA9633_Device_TypeDef* Device, uint8_t Value0, uint8_t Value1, uint8_t Value2, uint8_t Value3)
+{
+	if (Value0 < 4 && Value1 < 4 && Value2 < 4 && Value3 < 4)
+		setRegister(Device, PCA9633_LEDOUT, Value3 << 6 | Value2 << 4 | Value1 << 2 | Value0);
+}
+
+uint8_t PCA9633_OutputIsInverted(PCA9633_Device_TypeDef* Device)
+{
+	return getRegister(Device, PCA9633_MODE2) & _BV(MODE2_INVRT);
+}
+
+void PCA9633_InvertOutputs(PCA9633_Device_TypeDef* Device)
+{
+	uint8_t value = getSharedRegister(Device, PCA9633_MODE2);
+	value |= _BV(MODE2_INVRT);
+	value &= ~MODE2_OUTNE;
+	setRegister(Device, PCA9633_MODE2, value);
 }
 
-void pca9633wakeUp()
+void PCA9633_NonInvertOutputs(PCA9633_Device_TypeDef* Device)
 {
-	uint8_t mode1Value;
-	if (activateRegister(PCA9633_MODE1) && TWI_RequestFrom(PCA9633_ADDRESS, &mode1Value, 1))
+	setRegister(Device, PCA9633_MODE2, getSharedRegister(Device, PCA9633_MODE2) & ~_BV(MODE2_INVRT));
+}
+
+void PCA9633_SetOeMode(PCA9633_Device_TypeDef* Device, uint8_t Mode)
+{
+	if (Mode < 0x03)
 	{
-		mode1Value &= ~_BV(4);
-		setRegister(PCA9633_MODE1, mode1Value);
+		uint8_t value = getSharedRegister(Device, PCA9633_MODE2);
+		value &= ~MODE2_OUTNE;
+		value |= Mode;
+		setRegister(Device, PCA9633_MODE2, value);
 	}
 }
 
-uint8_t pca9633isSleeping()
+/************************************************************************
+	PCA9633 Group dimming and blinking
+ ***********************************************************************/
+/*
+	Dims all outputs in PWM mode with GRPPWM on top of their own PWM, they
+	are moved to PCA9633_LEDOUT_PWM_AND_GROUP. A fade of all outputs is
+	then one register write per step.
+*/
+void PCA9633_SetGroupDimming(PCA9633_Device_TypeDef* Device, uint8_t Brightness)
+{
+	setRegister(Device, PCA9633_MODE2, getSharedRegister(Device, PCA9633_MODE2) & ~_BV(MODE2_DMBLNK));
+	
+	uint8_t ledout = getSharedRegister(Device, PCA9633_LEDOUT);
+	uint8_t values[3] = {Brightness, getSharedRegister(Device, PCA9633_GRPFREQ), ledout | (LEDOUT_PWM(ledout) >> 1)};
+	setRegisters(Device, PCA9633_GRPPWM, values, 3);
+}
+
+/*
+	Blinks all outputs in PWM mode, on for dutyCycle/256 of the period. The
+	period is rounded to 1/24 s and limited to PCA9633_BLINK_MIN_PERIOD_MS
+	- PCA9633_BLINK_MAX_PERIOD_MS.
+*/
+void PCA9633_SetGroupBlinking(PCA9633_Device_TypeDef* Device, uint16_t PeriodMs, uint8_t DutyCycle)
+{
+	if (PeriodMs < PCA9633_BLINK_MIN_PERIOD_MS) PeriodMs = PCA9633_BLINK_MIN_PERIOD_MS;
+	if (PeriodMs > PCA9633_BLINK_MAX_PERIOD_MS) PeriodMs = PCA9633_BLINK_MAX_PERIOD_MS;
+	uint8_t frequency = ((uint32_t)PeriodMs * 24 + 500) / 1000 - 1;
+	
+	uint8_t ledout = getSharedRegister(Device, PCA9633_LEDOUT);
+	uint8_t values[3] = {DutyCycle, frequency, ledout | (LEDOUT_PWM(ledout) >> 1)};
+	setRegisters(Device, PCA9633_GRPPWM, values, 3);
+	setRegister(Device, PCA9633_MODE2, getSharedRegister(Device, PCA9633_MODE2) | _BV(MODE2_DMBLNK));
+}
+
+/*
+	Stops the group dimming or blinking, the outputs are moved back to
+	PCA9633_LEDOUT_PWM
+*/
+void PCA9633_StopGroup(PCA9633_Device_TypeDef* Device)
 {
-	uint8_t mode1Value;
-	if (activateRegister(PCA9633_MODE1) && TWI_RequestFrom(PCA9633_ADDRESS, &mode1Value, 1))
-		return mode1Value & _BV(4);
-		
-	return 2;
+	uint8_t ledout = getSharedRegister(Device, PCA9633_LEDOUT);
+	setRegister(Device, PCA9633_LEDOUT, ledout & ~(LEDOUT_GROUP(ledout) >> 1));
+	setRegister(Device, PCA9633_MODE2, getSharedRegister(Device, PCA9633_MODE2) & ~_BV(MODE2_DMBLNK));
+	setRegister(Device, PCA9633_GRPPWM, 0xFF);
 }
 
 /************************************************************************
-	PCA9633 Configuration
+	PCA9633 Broadcast addresses
  ***********************************************************************/
-void pca9633setLedoutRegister(const uint8_t value0, const uint8_t value1, const uint8_t value2, const uint8_t value3)
+/*
+	Sets the 7-bit All Call address the PCA9633 responds to, 0 turns
+	All Call off
+*/
+void PCA9633_SetAllCallAddress(PCA9633_Device_TypeDef* Device, uint8_t Address)
 {
-	if (value0 < 4 && value1 < 4 && value2 < 4 && value3 < 4)
+	uint8_t mode1 = getSharedRegister(Device, PCA9633_MODE1) & ~_BV(MODE1_ALLCALL);
+	if (Address)
 	{
-		setRegister(PCA9633_MODE1, 0x00);
-		volatile uint8_t totalValue = value3 << 6 | value2 << 4 | value1 << 2 | value0;
-		setRegister(PCA9633_LEDOUT, totalValue);
+		setRegister(Device, PCA9633_ALLCALLADR, Address << 1);
+		mode1 |= _BV(MODE1_ALLCALL);
 	}
+	setRegister(Device, PCA9633_MODE1, mode1);
 }
 
-uint8_t pca9633outputIsInverted()
+/*
+	Sets subaddress 1-3 the PCA9633 responds to, 0 turns the subaddress off
+*/
+void PCA9633_SetSubAddress(PCA9633_Device_TypeDef* Device, uint8_t SubAddress, uint8_t Address)
 {
-	activateRegister(PCA9633_MODE2);
-	uint8_t value;
-	TWI_RequestFrom(PCA9633_ADDRESS, &value, 1);
-	return value & _BV(4);
+	if (SubAddress < 1 || SubAddress > 3)
+		return;
+	
+	// SUB1 is bit 3 and SUB3 is bit 1 in MODE1
+	uint8_t bit = 4 - SubAddress;
+	uint8_t mode1 = getSharedRegister(Device, PCA9633_MODE1) & ~_BV(bit);
+	if (Address)
+	{
+		setRegister(Device, PCA9633_SUBADR1 + SubAddress - 1, Address << 1);
+		mode1 |= _BV(bit);
+	}
+	setRegister(Device, PCA9633_MODE1, mode1);
 }
 
-void pca9633invertOutputs()
+/************************************************************************
+	"Public" functions, work on the device at PCA9633_ADDRESS
+ ***********************************************************************/
+void pca9633setup()
 {
-	activateRegister(PCA9633_MODE2);
-	uint8_t value;
-	TWI_RequestFrom(PCA9633_ADDRESS, &value, 1);
-	value |= _BV(4);
-	value &= ~(_BV(0) | _BV(1));
-	setRegister(PCA9633_MODE2, value);
+	static uint8_t setupDone = 0;
+	if (!setupDone)
+	{
+		PCA9633_Init(&_pca9633Default, PCA9633_ADDRESS, &PCA9633_OE_PORT, PCA9633_OE);
+		setupDone = 1;
+	}
 }
 
-void pca9633nonInvertOutputs()
+void pca9633setOutput(const uint8_t output, const uint8_t value) { PCA9633_SetOutput(&_pca9633Default, output, value); }
+
+void pca9633setAllOutputs(const uint8_t value0, const uint8_t value1, const uint8_t value2, const uint8_t value3)
 {
-	activateRegister(PCA9633_MODE2);
-	uint8_t value;
-	TWI_RequestFrom(PCA9633_ADDRESS, &value, 1);
-	value &= ~_BV(4);
-	setRegister(PCA9633_MODE2, value);
+	PCA9633_SetAllOutputs(&_pca9633Default, value0, value1, value2, value3);
 }
 
-void pca9633setOeMode(uint8_t mode)
+void pca9633outputOff() { PCA9633_OutputOff(&_pca9633Default); }
+void pca9633outputOn() { PCA9633_OutputOn(&_pca9633Default); }
+uint8_t pca9633outputIsOn() { return PCA9633_OutputIsOn(&_pca9633Default); }
+rgba8 pca9633getRgba() { return PCA9633_GetRgba(&_pca9633Default); }
+
+uint8_t pca9633syncRegisters() { return PCA9633_SyncRegisters(&_pca9633Default); }
+uint8_t pca9633verifyRegisters() { return PCA9633_VerifyRegisters(&_pca9633Default); }
+
+void pca9633goToSleep() { PCA9633_Sleep(&_pca9633Default); }
+void pca9633wakeUp() { PCA9633_Wake(&_pca9633Default); }
+uint8_t pca9633isSleeping() { return PCA9633_IsSleeping(&_pca9633Default); }
+
+void pca9633setLedoutRegister(const uint8_t value0, const uint8_t value1, const uint8_t value2, const uint8_t value3)
 {
-	if (mode < 0x03)
+	if (value0 < 4 && value1 < 4 && value2 < 4 && value3 < 4)
 	{
-		activateRegister(PCA9633_MODE2);
-		uint8_t value;
-		TWI_RequestFrom(PCA9633_ADDRESS, &value, 1);
-		value &= ~0x02;
-		value |= mode;
-		setRegister(PCA9633_MODE2, value);
+		setRegister(&_pca9633Default, PCA9633_MODE1, 0x00);
+		PCA9633_SetLedout(&_pca9633Default, value0, value1, value2, value3);
 	}
 }
 
+uint8_t pca9633outputIsInverted() { return PCA9633_OutputIsInverted(&_pca9633Default); }
+void pca9633invertOutputs() { PCA9633_InvertOutputs(&_pca9633Default); }
+void pca9633nonInvertOutputs() { PCA9633_NonInvertOutputs(&_pca9633Default); }
+void pca9633setOeMode(uint8_t mode) { PCA9633_SetOeMode(&_pca9633Default, mode); }
 
 /************************************************************************
 	PCA9633 Test
@@ -216,10 +469,6 @@ void pca9633test()
 void pca9633readAllRegisters()
 {
 	uint8_t storage[PCA9633_REGISTER_COUNT];
-	TWI_BeginTransmission(PCA9633_ADDRESS);
-	TWI_Write(PCA9633_AUTO_INC_ALL | PCA9633_MODE1);
-	TWI_EndTransmission();
-	
- 	TWI_RequestFrom(PCA9633_ADDRESS, storage, PCA9633_REGISTER_COUNT);
+	readAllRegisters(&_pca9633Default, storage);
 }
 #endif
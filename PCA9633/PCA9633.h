@@ -3,14 +3,14 @@
  *
  * Created: 11/23/2012 9:50:45 PM
  *  Author: Hampus
- */ 
+ */
 
 #ifndef PCA9633_H_
 #define PCA9633_H_
 
 // Why do I have to include these here?
 #include <avr/io.h>
-#include <COLOR_8_BIT/color_8_bit.h>
+#include <COLOR/color.h>
 
 #define PCA9633_AUTO_INC_NO				0x00
 #define PCA9633_AUTO_INC_ALL			0x80
@@ -43,6 +43,13 @@
 #define PCA9633_LEDOUT_PWM				0x02
 #define PCA9633_LEDOUT_PWM_AND_GROUP	0x03
 
+// Default All Call address of the PCA9633, 7-bit
+#define PCA9633_ALL_CALL_ADDRESS	0x70
+
+// Blink period of the group is (GRPFREQ + 1) / 24 s
+#define PCA9633_BLINK_MIN_PERIOD_MS	42
+#define PCA9633_BLINK_MAX_PERIOD_MS	10667
+
 #ifndef PCA9633_ADDRESS
 #define PCA9633_ADDRESS		0x60
 #endif
@@ -54,6 +61,56 @@
 #define PCA9633_OE_PINX		PINB
 #endif
 
+/*
+	One PCA9633, or a group of them on a broadcast address (All Call or a
+	subaddress). The registers are kept in RAM so they never have to be
+	read before they are changed. Writes to a broadcast device are copied
+	to the registers of its members.
+*/
+typedef struct PCA9633_Device
+{
+	uint8_t address;
+	volatile uint8_t* oePort;	// PORTx of the OE pin, 0 if OE is not connected
+	uint8_t oePin;
+	uint8_t registers[PCA9633_REGISTER_COUNT];
+	uint8_t registersValid;
+	struct PCA9633_Device* const* members;	// Only for broadcast devices
+	uint8_t numOfMembers;
+} PCA9633_Device_TypeDef;
+
+// Device
+uint8_t PCA9633_Init(PCA9633_Device_TypeDef* Device, uint8_t Address, volatile uint8_t* OePort, uint8_t OePin);
+void PCA9633_InitBroadcast(PCA9633_Device_TypeDef* Device, uint8_t Address,
+						PCA9633_Device_TypeDef* const* Members, uint8_t NumOfMembers);
+void PCA9633_SetOutput(PCA9633_Device_TypeDef* Device, uint8_t Output, uint8_t Value);
+void PCA9633_SetAllOutputs(PCA9633_Device_TypeDef* Device, uint8_t Value0, uint8_t Value1, uint8_t Value2, uint8_t Value3);
+rgba8 PCA9633_GetRgba(PCA9633_Device_TypeDef* Device);
+void PCA9633_OutputOff(PCA9633_Device_TypeDef* Device);
+void PCA9633_OutputOn(PCA9633_Device_TypeDef* Device);
+uint8_t PCA9633_OutputIsOn(PCA9633_Device_TypeDef* Device);
+uint8_t PCA9633_SyncRegisters(PCA9633_Device_TypeDef* Device);
+uint8_t PCA9633_VerifyRegisters(PCA9633_Device_TypeDef* Device);
+
+void PCA9633_Sleep(PCA9633_Device_TypeDef* Device);
+void PCA9633_Wake(PCA9633_Device_TypeDef* Device);
+uint8_t PCA9633_IsSleeping(PCA9633_Device_TypeDef* Device);
+
+void PCA9633_SetLedout(PCA9633_Device_TypeDef* Device, uint8_t Value0, uint8_t Value1, uint8_t Value2, uint8_t Value3);
+uint8_t PCA9633_OutputIsInverted(PCA9633_Device_TypeDef* Device);
+void PCA9633_InvertOutputs(PCA9633_Device_TypeDef* Device);
+void PCA9633_NonInvertOutputs(PCA9633_Device_TypeDef* Device);
+void PCA9633_SetOeMode(PCA9633_Device_TypeDef* Device, uint8_t Mode);
+
+void PCA9633_SetGroupDimming(PCA9633_Device_TypeDef* Device, uint8_t Brightness);
+void PCA9633_SetGroupBlinking(PCA9633_Device_TypeDef* Device, uint16_t PeriodMs, uint8_t DutyCycle);
+void PCA9633_StopGroup(PCA9633_Device_TypeDef* Device);
+
+void PCA9633_SetAllCallAddress(PCA9633_Device_TypeDef* Device, uint8_t Address);
+void PCA9633_SetSubAddress(PCA9633_Device_TypeDef* Device, uint8_t SubAddress, uint8_t Address);
+
+// The device at PCA9633_ADDRESS with OE on PCA9633_OE
+extern PCA9633_Device_TypeDef _pca9633Default;
+
 void pca9633setup();
 void pca9633setOutput(const uint8_t output, const uint8_t value);
 void pca9633setAllOutputs(const uint8_t value0, const uint8_t value1, const uint8_t value2, const uint8_t value3);
@@ -62,6 +119,10 @@ void pca9633outputOn();
 uint8_t pca9633outputIsOn();
 rgba8 pca9633getRgba();
 
+// Register copy
+uint8_t pca9633syncRegisters();
+uint8_t pca9633verifyRegisters();
+
 // Sleep
 void pca9633goToSleep();
 void pca9633wakeUp();
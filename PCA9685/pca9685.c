@@ -10,6 +10,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <avr/io.h>
+#include <util/delay.h>
 #include <atmega328x/twi.h>
 #include <assert/assert.h>
 #include "pca9685.h"
@@ -52,8 +53,107 @@
 #define MAX_OUTPUT_INDEX	15
 #define MAX_OUTPUT_VALUE	0xFFF
 
+// Bit 4 of LEDn_ON_H and LEDn_OFF_H, turns the output fully on or off
+#define FULL_ON_OFF_BIT		4
+
+#define MIN_PRESCALE		3
+#define MAX_PRESCALE		255
+
+// Time for the oscillator to start after SLEEP is cleared
+#define OSCILLATOR_START_US	500
+
+#ifdef PCA9685_STAGGER
+#define ON_VALUE(OUTPUT)	(((OUTPUT) * PCA9685_STAGGER_STEP) & MAX_OUTPUT_VALUE)
+#else
+#define ON_VALUE(OUTPUT)	0
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Writes a register of a PCA9685
+ * @param	Address: The address to the PCA9685
+ * @param	Register: The register to write
+ * @param	Value: The value to write
+ * @retval	None
+ */
+static void writeRegister(uint8_t Address, uint8_t Register, uint8_t Value)
+{
+	TWI_BeginTransmission(Address);
+	TWI_Write(Register);
+	TWI_Write(Value);
+	TWI_EndTransmission();
+}
+
+/**
+ * @brief	Reads a register of a PCA9685
+ * @param	Address: The address to the PCA9685, not the All Call address
+ * @param	Register: The register to read
+ * @retval	The value of the register
+ */
+static uint8_t readRegister(uint8_t Address, uint8_t Register)
+{
+	uint8_t value = 0;
+	TWI_BeginTransmission(Address);
+	TWI_Write(Register);
+	TWI_EndTransmission();
+	TWI_RequestFrom(Address, &value, 1);
+	return value;
+}
+
+/**
+ * @brief	Calculates the prescale for a frequency
+ * @param	Clock: The frequency of the oscillator in Hz
+ * @param	Frequency: The PWM frequency in Hz
+ * @retval	The prescale, limited to what the PCA9685 supports
+ */
+static uint8_t prescaleForFrequency(uint32_t Clock, uint16_t Frequency)
+{
+	// round(Clock / (4096 * Frequency)) - 1
+	uint32_t period = 4096UL * Frequency;
+	uint32_t prescale = (Clock + period / 2) / period;
+	if (prescale < MIN_PRESCALE + 1) return MIN_PRESCALE;
+	if (prescale > MAX_PRESCALE + 1) return MAX_PRESCALE;
+	return prescale - 1;
+}
+
+/**
+ * @brief	Clears SLEEP in MODE1 and restarts the PWM if it was running before
+ *			it was put to sleep
+ * @param	Address: The address to the PCA9685
+ * @param	Mode1: MODE1 without SLEEP
+ * @retval	None
+ */
+static void wakeUp(uint8_t Address, uint8_t Mode1)
+{
+	uint8_t restart = readRegister(Address, MODE1) & (1 << MODE1_RESTART);
+	// Writing 0 to RESTART has no effect
+	writeRegister(Address, MODE1, Mode1 & ~((1 << MODE1_SLEEP) | (1 << MODE1_RESTART)));
+	_delay_us(OSCILLATOR_START_US);
+	if (restart)
+		writeRegister(Address, MODE1, (Mode1 & ~(1 << MODE1_SLEEP)) | (1 << MODE1_RESTART));
+}
+
+/**
+ * @brief	Writes the four registers of an output that turns on at ON_VALUE
+ *			and stays on for Duty counts, the transmission must have been started
+ * @param	Output: The output, used for the stagger
+ * @param	Duty: Number of counts the output is on, 0-4095
+ * @retval	None
+ */
+static void writeDuty(uint8_t Output, uint16_t Duty)
+{
+	uint16_t onValue = ON_VALUE(Output);
+	uint16_t offValue = (onValue + Duty) & MAX_OUTPUT_VALUE;
+	// ON and OFF should not have the same value, use full off instead
+	if (Duty == 0) offValue = 1 << (8 + FULL_ON_OFF_BIT);
+	
+	TWI_Write(onValue & 0xFF);		// LEDn_ON_L
+	TWI_Write(onValue >> 8);		// LEDn_ON_H
+	TWI_Write(offValue & 0xFF);		// LEDn_OFF_L
+	TWI_Write(offValue >> 8);		// LEDn_OFF_H
+}
+
 /* Functions -----------------------------------------------------------------*/
 
 /**
@@ -69,6 +169,7 @@ uint8_t PCA9685_Init(PCA9685_Init_TypeDef *PCA9685_InitStruct)
     assert_param(IS_PCA9685_OUTPUT_DRIVER(PCA9685_InitStruct->OutputDriver));
     assert_param(IS_PCA9685_OUTPUT_NOT_EN(PCA9685_InitStruct->OutputNotEn));
 	assert_param(IS_PCA9685_FREQUENCY(PCA9685_InitStruct->PWMFrequency));
+	assert_param(IS_PCA9685_CLOCK(PCA9685_InitStruct->Clock));
 
 	if (!TWI_Initialized())
 		TWI_InitStandard();
@@ -77,17 +178,31 @@ uint8_t PCA9685_Init(PCA9685_Init_TypeDef *PCA9685_InitStruct)
 	
 	if (TWI_SlaveAtAddress(PCA9685_InitStruct->Address))
 	{
+		uint8_t address = PCA9685_InitStruct->Address;
+		
 		/* MODE1 Register:
-		 * Internal clock
 		 * Register Auto-Increment enabled
-		 * Normal mode
 		 * Does not respond to subaddresses
 		 * Responds to All Call I2C-bus address
+		 * Sleep while the clock and prescale are set, PRE_SCALE can only be
+		 * written when SLEEP is set
 		 */
-		TWI_BeginTransmission(PCA9685_InitStruct->Address);
-		TWI_Write(MODE1);
-		TWI_Write((1 << MODE1_AI) | (1 << MODE1_ALLCALL));
-		TWI_EndTransmission();
+		uint8_t mode1 = (1 << MODE1_AI) | (1 << MODE1_ALLCALL);
+		writeRegister(address, MODE1, mode1 | (1 << MODE1_SLEEP));
+		
+		uint32_t clock = PCA9685_INTERNAL_CLOCK;
+		if (PCA9685_InitStruct->Clock == PCA9685_Clock_External)
+		{
+			// EXTCLK must be set while sleeping and is sticky until reset
+			mode1 |= (1 << MODE1_EXTCLK);
+			writeRegister(address, MODE1, mode1 | (1 << MODE1_SLEEP));
+			clock = PCA9685_EXTERNAL_CLOCK;
+		}
+		
+		/* PRE_SCALE Register:
+		 * Set from PCA9685_InitStruct->PWMFrequency
+		 */
+		writeRegister(address, PRE_SCALE, prescaleForFrequency(clock, PCA9685_InitStruct->PWMFrequency));
 		
 		/* MODE2 Register:
 		 * Outputs change on STOP command
@@ -95,38 +210,11 @@ uint8_t PCA9685_Init(PCA9685_Init_TypeDef *PCA9685_InitStruct)
 		uint8_t mode2 = (PCA9685_InitStruct->InvOutputs << MODE2_INVRT) |
 		(PCA9685_InitStruct->OutputDriver << MODE2_OUTDRV) |
 		(PCA9685_InitStruct->OutputNotEn << MODE2_OUTNE0);
-		TWI_BeginTransmission(PCA9685_InitStruct->Address);
-		TWI_Write(MODE2);
-		TWI_Write(mode2);
-		TWI_EndTransmission();
+		writeRegister(address, MODE2, mode2);
 		
-		/* PRE_SCALE Register:
-		 * Set to value specified in PCA9685_InitStruct->PWMFrequency;
-		 */
-		TWI_BeginTransmission(PCA9685_InitStruct->Address);
-		TWI_Write(PRE_SCALE);
-		TWI_Write(PCA9685_InitStruct->PWMFrequency);
-		TWI_EndTransmission();
-		
-		
-		
-		// TESTING - 50% Duty. On at 0 and off at 2047 (0x7FF)
-		TWI_BeginTransmission(PCA9685_InitStruct->Address);
-		TWI_Write(LEDn_ON_L(1));
-		TWI_Write(0x00);	// ALL_LED_ON_L
- 		TWI_Write(0x00);	// ALL_LED_ON_H
- 		TWI_Write(0xFF);	// ALL_LED_OFF_L
- 		TWI_Write(0x07);	// ALL_LED_OFF_H
-		TWI_EndTransmission();
-		
-		PCA9685_SetDutyCycleForOutput(PCA9685_InitStruct->Address, 1, 50);
-
-		TWI_BeginTransmission(PCA9685_InitStruct->Address);
-		TWI_Write(LEDn_ON_L(1));
-		TWI_EndTransmission();
-		volatile uint8_t data[4] = {};
-		twiStatus = TWI_RequestFrom(PCA9685_InitStruct->Address, data, 4);
-		volatile uint8_t test = 0;
+		// Normal mode
+		wakeUp(address, mode1);
+		twiStatus = 1;
  	}
 	
 	return twiStatus;
@@ -155,6 +243,136 @@ void PCA9685_SetOutput(uint8_t Address, uint8_t Output, uint16_t OnValue, uint16
 	}
 }
 
+/**
+ * @brief	Sets several outputs in a row in one transaction, the registers are
+ *			written with auto-increment. The outputs turn on at 0, or staggered
+ *			with PCA9685_STAGGER.
+ * @param	Address: The address to the PCA9685 or PCA9685_ALL_CALL_ADDRESS
+ * @param	FirstOutput: The first output to set
+ * @param	Count: Number of outputs to set
+ * @param	Values: Number of counts each output is on, Count values
+ * @retval	None
+ */
+void PCA9685_SetOutputs(uint8_t Address, uint8_t FirstOutput, uint8_t Count, const uint16_t* Values)
+{
+	if (FirstOutput > MAX_OUTPUT_INDEX || Count == 0) return;
+	if (Count > PCA9685_NUM_OF_OUTPUTS - FirstOutput) Count = PCA9685_NUM_OF_OUTPUTS - FirstOutput;
+	
+	TWI_BeginTransmission(Address);
+	TWI_Write(LEDn_ON_L(FirstOutput));
+	for (uint8_t i = 0; i < Count; i++)
+	{
+		uint16_t offValue = Values[i];
+		if (offValue > MAX_OUTPUT_VALUE) offValue = MAX_OUTPUT_VALUE;
+		writeDuty(FirstOutput + i, offValue);
+	}
+	TWI_EndTransmission();
+}
+
+/**
+ * @brief	Sets all outputs of a PCA9685 to the same values with the ALL_LED registers
+ * @param	Address: The address to the PCA9685 or PCA9685_ALL_CALL_ADDRESS
+ * @param	OnValue: The value at which the outputs will turn on
+ * @param	OffValue: The value at which the outputs will turn off
+ * @retval	None
+ */
+void PCA9685_SetAllOutputs(uint8_t Address, uint16_t OnValue, uint16_t OffValue)
+{
+	if (OnValue <= MAX_OUTPUT_VALUE && OffValue <= MAX_OUTPUT_VALUE)
+	{
+		TWI_BeginTransmission(Address);
+		TWI_Write(ALL_LED_ON_L);
+		TWI_Write(OnValue & 0xFF);			// ALL_LED_ON_L
+		TWI_Write((OnValue >> 8) & 0xF);	// ALL_LED_ON_H
+		TWI_Write(OffValue & 0xFF);			// ALL_LED_OFF_L
+		TWI_Write((OffValue >> 8) & 0xF);	// ALL_LED_OFF_H
+		TWI_EndTransmission();
+	}
+}
+
+/**
+ * @brief	Turns all outputs of a PCA9685 fully on
+ * @param	Address: The address to the PCA9685 or PCA9685_ALL_CALL_ADDRESS
+ * @retval	None
+ */
+void PCA9685_AllOn(uint8_t Address)
+{
+	TWI_BeginTransmission(Address);
+	TWI_Write(ALL_LED_ON_L);
+	TWI_Write(0x00);					// ALL_LED_ON_L
+	TWI_Write(1 << FULL_ON_OFF_BIT);	// ALL_LED_ON_H
+	TWI_Write(0x00);					// ALL_LED_OFF_L
+	TWI_Write(0x00);					// ALL_LED_OFF_H
+	TWI_EndTransmission();
+}
+
+/**
+ * @brief	Turns all outputs of a PCA9685 fully off
+ * @param	Address: The address to the PCA9685 or PCA9685_ALL_CALL_ADDRESS
+ * @retval	None
+ */
+void PCA9685_AllOff(uint8_t Address)
+{
+	TWI_BeginTransmission(Address);
+	TWI_Write(ALL_LED_OFF_H);
+	TWI_Write(1 << FULL_ON_OFF_BIT);	// ALL_LED_OFF_H
+	TWI_EndTransmission();
+}
+
+/**
+ * @brief	Changes the All Call address a PCA9685 responds to
+ * @param	Address: The address to the PCA9685 or PCA9685_ALL_CALL_ADDRESS
+ * @param	AllCallAddress: The new 7-bit All Call address
+ * @retval	None
+ */
+void PCA9685_SetAllCallAddress(uint8_t Address, uint8_t AllCallAddress)
+{
+	writeRegister(Address, ALLCALLADR, AllCallAddress << 1);
+}
+
+/**
+ * @brief	Changes the PWM frequency. The PCA9685 has to sleep while the
+ *			prescale is written so the outputs are off for about 500 us.
+ * @param	Address: The address to the PCA9685
+ * @param	Frequency: The frequency in Hz, see PCA9685_Frequency
+ * @retval	None
+ */
+void PCA9685_SetFrequency(uint8_t Address, uint16_t Frequency)
+{
+	assert_param(IS_PCA9685_FREQUENCY(Frequency));
+	
+	uint8_t mode1 = readRegister(Address, MODE1);
+	uint32_t clock = (mode1 & (1 << MODE1_EXTCLK)) ? PCA9685_EXTERNAL_CLOCK : PCA9685_INTERNAL_CLOCK;
+	
+	writeRegister(Address, MODE1, (mode1 & ~(1 << MODE1_RESTART)) | (1 << MODE1_SLEEP));
+	writeRegister(Address, PRE_SCALE, prescaleForFrequency(clock, Frequency));
+	if (!(mode1 & (1 << MODE1_SLEEP)))
+		wakeUp(Address, mode1);
+}
+
+/**
+ * @brief	Puts a PCA9685 in low power mode, the oscillator and all outputs
+ *			are turned off
+ * @param	Address: The address to the PCA9685
+ * @retval	None
+ */
+void PCA9685_Sleep(uint8_t Address)
+{
+	uint8_t mode1 = readRegister(Address, MODE1);
+	writeRegister(Address, MODE1, (mode1 & ~(1 << MODE1_RESTART)) | (1 << MODE1_SLEEP));
+}
+
+/**
+ * @brief	Wakes a PCA9685 up from low power mode and restarts the outputs
+ *			with the values they had before
+ * @param	Address: The address to the PCA9685
+ * @retval	None
+ */
+void PCA9685_Wake(uint8_t Address)
+{
+	wakeUp(Address, readRegister(Address, MODE1));
+}
+
 /**
  * @brief	Sets a specific output for a PCA9685 based on an approximate duty cycle
  * @param	Address: The address to the PCA9685
@@ -164,9 +382,15 @@ void PCA9685_SetOutput(uint8_t Address, uint8_t Output, uint16_t OnValue, uint16
  */
 void PCA9685_SetDutyCycleForOutput(uint8_t Address, uint8_t Output, uint8_t DutyCycle)
 {
-	uint16_t offValue = DutyCycle * 41; // 0 - 4100
-	if (offValue > MAX_OUTPUT_VALUE) offValue = MAX_OUTPUT_VALUE;
-	PCA9685_SetOutput(Address, Output, 0, offValue);
+	if (DutyCycle > 100) DutyCycle = 100;
+	uint16_t offValue = ((uint32_t)DutyCycle * MAX_OUTPUT_VALUE + 50) / 100; // 0 - 4095
+	if (Output <= MAX_OUTPUT_INDEX)
+	{
+		TWI_BeginTransmission(Address);
+		TWI_Write(LEDn_ON_L(Output));
+		writeDuty(Output, offValue);
+		TWI_EndTransmission();
+	}
 }
 
 /* Interrupt Service Routines ------------------------------------------------*/
\ No newline at end of file
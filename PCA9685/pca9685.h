@@ -14,6 +14,33 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Defines -------------------------------------------------------------------*/
+/*
+ * All PCA9685 on the bus respond to the All Call address after PCA9685_Init,
+ * any of the write functions can be used with it to update all of them at
+ * the same time. Reads do not work on the All Call address.
+ */
+#define PCA9685_ALL_CALL_ADDRESS	0x70
+
+#define PCA9685_NUM_OF_OUTPUTS		16
+
+// Frequency of the internal oscillator
+#define PCA9685_INTERNAL_CLOCK		25000000UL
+
+// Frequency of the clock on EXTCLK when PCA9685_Clock_External is used, at most 50 MHz
+#ifndef PCA9685_EXTERNAL_CLOCK
+#define PCA9685_EXTERNAL_CLOCK		PCA9685_INTERNAL_CLOCK
+#endif
+
+/*
+ * Define PCA9685_STAGGER to turn on each output PCA9685_STAGGER_STEP counts
+ * after the one before it instead of all at 0. The current is then spread
+ * over the period which gives less ripple on the supply. Only
+ * PCA9685_SetOutputs and PCA9685_SetDutyCycleForOutput use it, the values
+ * given to PCA9685_SetOutput and the ALL_LED functions are written as they are.
+ */
+#ifndef PCA9685_STAGGER_STEP
+#define PCA9685_STAGGER_STEP		(4096 / PCA9685_NUM_OF_OUTPUTS)
+#endif
 
 /* Typedefs ------------------------------------------------------------------*/
 /**
@@ -53,20 +80,32 @@ typedef enum
 										((OUTNE) <= PCA9685_OutputNotEn_High_Z2))
 										
 /**
- * @brief	PCA9685 Frequency
- *			Set by prescale = round(25 MHz / (4096 * freq)) - 1
+ * @brief	PCA9685 Clock source
+ */
+typedef enum
+{
+	PCA9685_Clock_Internal =	0,
+	PCA9685_Clock_External =	1
+} PCA9685_Clock_TypeDef;
+#define IS_PCA9685_CLOCK(CLOCK)	(((CLOCK) == PCA9685_Clock_Internal) || \
+								((CLOCK) == PCA9685_Clock_External))
+
+/**
+ * @brief	PCA9685 Frequency in Hz, any frequency between PCA9685_Frequency_Min
+ *			and PCA9685_Frequency_Max can be used.
+ *			Set by prescale = round(clock / (4096 * freq)) - 1
  */
 typedef enum
 {
-	PCA9685_Frequency_200Hz =	30,
-	PCA9685_Frequency_100Hz =	60,
-	PCA9685_Frequency_60Hz =	100,
-	PCA9685_Frequency_50Hz =	121
+	PCA9685_Frequency_Min =		24,
+	PCA9685_Frequency_50Hz =	50,
+	PCA9685_Frequency_60Hz =	60,
+	PCA9685_Frequency_100Hz =	100,
+	PCA9685_Frequency_200Hz =	200,
+	PCA9685_Frequency_Max =		1526
 } PCA9685_Frequency;
-#define IS_PCA9685_FREQUENCY(FREQ) ((FREQ) == PCA9685_Frequency_200Hz || \
-									(FREQ) == PCA9685_Frequency_100Hz || \
-									(FREQ) == PCA9685_Frequency_60Hz || \
-									(FREQ) == PCA9685_Frequency_50Hz)
+#define IS_PCA9685_FREQUENCY(FREQ) (((FREQ) >= PCA9685_Frequency_Min) && \
+									((FREQ) <= PCA9685_Frequency_Max))
 
 /**
  * @brief	PCA9685 Init structure definition
@@ -80,8 +119,12 @@ typedef struct
     												This parameter can be any value of PCA9685_OutputDriver_TypeDef */
 	PCA9685_OutputNotEn_TypeDef OutputNotEn;	/** Specifies what the outputs should be when OE=1
     												This parameter can be any value of PCA9685_OutputNotEn_TypeDef */
-	PCA9685_Frequency PWMFrequency;				/** Specifies what output frequency to use
-    												This parameter can be any value of PCA9685_Frequency */
+	uint16_t PWMFrequency;						/** Specifies what output frequency to use in Hz
+    												This parameter can be any value of PCA9685_Frequency or
+    												a frequency in between PCA9685_Frequency_Min and _Max */
+	PCA9685_Clock_TypeDef Clock;				/** Specifies the clock source, EXTCLK can only be turned
+    												off again by a reset
+    												This parameter can be any value of PCA9685_Clock_TypeDef */
 } PCA9685_Init_TypeDef;
 
 
@@ -89,6 +132,14 @@ typedef struct
 uint8_t PCA9685_Init(PCA9685_Init_TypeDef *PCA9685_InitStruct);
 
 void PCA9685_SetOutput(uint8_t Address, uint8_t Output, uint16_t OnValue, uint16_t OffValue);
+void PCA9685_SetOutputs(uint8_t Address, uint8_t FirstOutput, uint8_t Count, const uint16_t* Values);
+void PCA9685_SetAllOutputs(uint8_t Address, uint16_t OnValue, uint16_t OffValue);
+void PCA9685_AllOn(uint8_t Address);
+void PCA9685_AllOff(uint8_t Address);
+void PCA9685_SetAllCallAddress(uint8_t Address, uint8_t AllCallAddress);
+void PCA9685_SetFrequency(uint8_t Address, uint16_t Frequency);
+void PCA9685_Sleep(uint8_t Address);
+void PCA9685_Wake(uint8_t Address);
 void PCA9685_SetDutyCycleForOutput(uint8_t Address, uint8_t Output, uint8_t DutyCycle);
 
 #endif /* PCA9685_H_ */
\ No newline at end of file
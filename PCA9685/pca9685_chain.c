@@ -0,0 +1,243 @@
+/**
+ ******************************************************************************
+ * @file	pca9685_chain.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions to manage several PCA9685 on one bus as one long
+ *			row of channels
+ *			- Shadow copy of the outputs of every device
+ *			- Only changed ranges of outputs are written
+ *			- Brightness groups across devices
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <assert/assert.h>
+#include "pca9685_chain.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define MAX_VALUE			0xFFF
+
+#define DEVICE(CHANNEL)		((CHANNEL) / PCA9685_NUM_OF_OUTPUTS)
+#define OUTPUT(CHANNEL)		((CHANNEL) % PCA9685_NUM_OF_OUTPUTS)
+
+/* Private variables ---------------------------------------------------------*/
+uint8_t _pca9685ChainAddress[PCA9685_CHAIN_MAX_DEVICES];
+uint8_t _pca9685ChainNumOfDevices;
+
+// The values that have been set, before the group brightness
+uint16_t _pca9685ChainValue[PCA9685_CHAIN_MAX_CHANNELS];
+// What is in the devices after the next update, the ON value is given by the output
+uint16_t _pca9685ChainShadow[PCA9685_CHAIN_MAX_DEVICES][PCA9685_NUM_OF_OUTPUTS];
+// One bit per output that has to be written at the next update
+uint16_t _pca9685ChainDirty[PCA9685_CHAIN_MAX_DEVICES];
+
+uint8_t _pca9685ChainGroup[PCA9685_CHAIN_MAX_CHANNELS];
+uint8_t _pca9685ChainGroupBrightness[PCA9685_CHAIN_NUM_OF_GROUPS];
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Calculates the output of a channel from its value and group
+ *			brightness and marks it as dirty if it changed
+ * @param	Channel: The channel
+ * @retval	None
+ */
+static void updateShadow(uint16_t Channel)
+{
+	uint8_t device = DEVICE(Channel);
+	uint8_t output = OUTPUT(Channel);
+	// Brightness 0 turns the output off and 255 gives back the value unchanged
+	uint16_t value = _pca9685ChainValue[Channel];
+	value = ((uint32_t)value * (_pca9685ChainGroupBrightness[_pca9685ChainGroup[Channel]] * 257U) + value) >> 16;
+	
+	if (_pca9685ChainShadow[device][output] != value)
+	{
+		_pca9685ChainShadow[device][output] = value;
+		_pca9685ChainDirty[device] |= (1U << output);
+	}
+}
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes all the devices in the chain with the same settings.
+ *			All channels are set to 0 and in group 0 with full brightness.
+ * @param	InitStruct: Settings for the devices, the address is not used
+ * @param	Addresses: The address of each device, in channel order
+ * @param	NumOfDevices: Number of devices, at most PCA9685_CHAIN_MAX_DEVICES
+ * @retval	1: All devices have been initialized
+ * @retval	0: At least one device did not answer
+ */
+uint8_t PCA9685_CHAIN_Init(PCA9685_Init_TypeDef* InitStruct, const uint8_t* Addresses, uint8_t NumOfDevices)
+{
+	assert_param(NumOfDevices <= PCA9685_CHAIN_MAX_DEVICES);
+	
+	if (NumOfDevices > PCA9685_CHAIN_MAX_DEVICES) NumOfDevices = PCA9685_CHAIN_MAX_DEVICES;
+	_pca9685ChainNumOfDevices = NumOfDevices;
+	
+	uint8_t status = 1;
+	for (uint8_t device = 0; device < NumOfDevices; device++)
+	{
+		_pca9685ChainAddress[device] = Addresses[device];
+		InitStruct->Address = Addresses[device];
+		if (!PCA9685_Init(InitStruct)) status = 0;
+		
+		// Write all outputs at the first update so the shadow matches the device
+		for (uint8_t output = 0; output < PCA9685_NUM_OF_OUTPUTS; output++)
+			_pca9685ChainShadow[device][output] = 0;
+		_pca9685ChainDirty[device] = 0xFFFF;
+	}
+	
+	for (uint16_t channel = 0; channel < PCA9685_CHAIN_MAX_CHANNELS; channel++)
+	{
+		_pca9685ChainValue[channel] = 0;
+		_pca9685ChainGroup[channel] = 0;
+	}
+	
+	for (uint8_t group = 0; group < PCA9685_CHAIN_NUM_OF_GROUPS; group++)
+		_pca9685ChainGroupBrightness[group] = 255;
+	
+	return status;
+}
+
+/**
+ * @brief	Sets the value of one channel
+ * @param	Channel: The channel
+ * @param	Value: Number of counts the output is on, 0-4095
+ * @retval	None
+ */
+void PCA9685_CHAIN_SetChannel(uint16_t Channel, uint16_t Value)
+{
+	if (Channel >= _pca9685ChainNumOfDevices * PCA9685_NUM_OF_OUTPUTS) return;
+	if (Value > MAX_VALUE) Value = MAX_VALUE;
+	
+	_pca9685ChainValue[Channel] = Value;
+	updateShadow(Channel);
+}
+
+/**
+ * @brief	Sets the values of several channels in a row, they can span more
+ *			than one device
+ * @param	FirstChannel: The first channel
+ * @param	Count: Number of channels
+ * @param	Values: Number of counts each output is on, Count values of 0-4095
+ * @retval	None
+ */
+void PCA9685_CHAIN_SetChannels(uint16_t FirstChannel, uint16_t Count, const uint16_t* Values)
+{
+	for (uint16_t i = 0; i < Count; i++)
+		PCA9685_CHAIN_SetChannel(FirstChannel + i, Values[i]);
+}
+
+/**
+ * @brief	Returns the value of a channel as it was set
+ * @param	Channel: The channel
+ * @retval	The value, 0-4095
+ */
+uint16_t PCA9685_CHAIN_GetChannel(uint16_t Channel)
+{
+	if (Channel >= _pca9685ChainNumOfDevices * PCA9685_NUM_OF_OUTPUTS) return 0;
+	return _pca9685ChainValue[Channel];
+}
+
+/**
+ * @brief	Moves a channel to a brightness group
+ * @param	Channel: The channel
+ * @param	Group: The group, less than PCA9685_CHAIN_NUM_OF_GROUPS
+ * @retval	None
+ */
+void PCA9685_CHAIN_SetGroup(uint16_t Channel, uint8_t Group)
+{
+	assert_param(Group < PCA9685_CHAIN_NUM_OF_GROUPS);
+	
+	if (Channel >= _pca9685ChainNumOfDevices * PCA9685_NUM_OF_OUTPUTS ||
+		Group >= PCA9685_CHAIN_NUM_OF_GROUPS) return;
+	
+	_pca9685ChainGroup[Channel] = Group;
+	updateShadow(Channel);
+}
+
+/**
+ * @brief	Sets the brightness of all the channels in a group
+ * @param	Group: The group, less than PCA9685_CHAIN_NUM_OF_GROUPS
+ * @param	Brightness: 0-255, 255 is full brightness
+ * @retval	None
+ */
+void PCA9685_CHAIN_SetGroupBrightness(uint8_t Group, uint8_t Brightness)
+{
+	assert_param(Group < PCA9685_CHAIN_NUM_OF_GROUPS);
+	
+	if (Group >= PCA9685_CHAIN_NUM_OF_GROUPS || _pca9685ChainGroupBrightness[Group] == Brightness) return;
+	
+	_pca9685ChainGroupBrightness[Group] = Brightness;
+	uint16_t numOfChannels = _pca9685ChainNumOfDevices * PCA9685_NUM_OF_OUTPUTS;
+	for (uint16_t channel = 0; channel < numOfChannels; channel++)
+	{
+		if (_pca9685ChainGroup[channel] == Group)
+			updateShadow(channel);
+	}
+}
+
+/**
+ * @brief	Checks if there are changes that PCA9685_CHAIN_Update has not written yet
+ * @param	None
+ * @retval	1 if there are changes, otherwise 0
+ */
+uint8_t PCA9685_CHAIN_UpdatePending()
+{
+	for (uint8_t device = 0; device < _pca9685ChainNumOfDevices; device++)
+	{
+		if (_pca9685ChainDirty[device]) return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief	Writes the outputs that have changed since the last update. Every
+ *			range of changed outputs in a device is written in one transaction.
+ * @param	None
+ * @retval	None
+ */
+void PCA9685_CHAIN_Update()
+{
+	for (uint8_t device = 0; device < _pca9685ChainNumOfDevices; device++)
+	{
+		uint16_t dirty = _pca9685ChainDirty[device];
+		uint8_t output = 0;
+		
+		while (dirty)
+		{
+			// Skip to the first changed output
+			while (!(dirty & 1))
+			{
+				dirty >>= 1;
+				output++;
+			}
+			
+			// The range ends when there are more than PCA9685_CHAIN_MAX_GAP unchanged outputs
+			uint8_t first = output;
+			uint8_t last = output;
+			uint8_t gap = 0;
+			while (dirty && gap <= PCA9685_CHAIN_MAX_GAP)
+			{
+				if (dirty & 1)
+				{
+					last = output;
+					gap = 0;
+				}
+				else
+					gap++;
+				dirty >>= 1;
+				output++;
+			}
+			
+			PCA9685_SetOutputs(_pca9685ChainAddress[device], first, last - first + 1,
+								&_pca9685ChainShadow[device][first]);
+		}
+		
+		_pca9685ChainDirty[device] = 0;
+	}
+}
+
+/* Interrupt Service Routines ------------------------------------------------*/
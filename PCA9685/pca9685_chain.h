@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file	pca9685_chain.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains defines and function prototypes to manage several PCA9685
+ *			on one bus as one long row of channels
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PCA9685_CHAIN_H_
+#define PCA9685_CHAIN_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "pca9685.h"
+
+/* Defines -------------------------------------------------------------------*/
+/*
+ * Channel n is output n % 16 of device n / 16, the devices are in the order
+ * of the addresses given to PCA9685_CHAIN_Init. Set functions only change the
+ * shadow registers, PCA9685_CHAIN_Update writes the outputs that changed.
+ */
+#ifndef PCA9685_CHAIN_MAX_DEVICES
+#define PCA9685_CHAIN_MAX_DEVICES	4
+#endif
+
+#define PCA9685_CHAIN_MAX_CHANNELS	(PCA9685_CHAIN_MAX_DEVICES * PCA9685_NUM_OF_OUTPUTS)
+
+/*
+ * Every channel belongs to a brightness group, all channels are in group 0
+ * after PCA9685_CHAIN_Init
+ */
+#ifndef PCA9685_CHAIN_NUM_OF_GROUPS
+#define PCA9685_CHAIN_NUM_OF_GROUPS	4
+#endif
+
+/*
+ * Unchanged outputs in between two changed ones are written again if there
+ * are at most this many of them. A new transaction costs about as much as
+ * one output (START, address, register and STOP).
+ */
+#ifndef PCA9685_CHAIN_MAX_GAP
+#define PCA9685_CHAIN_MAX_GAP		1
+#endif
+
+/* Typedefs ------------------------------------------------------------------*/
+/* Function prototypes -------------------------------------------------------*/
+uint8_t PCA9685_CHAIN_Init(PCA9685_Init_TypeDef* InitStruct, const uint8_t* Addresses, uint8_t NumOfDevices);
+void PCA9685_CHAIN_SetChannel(uint16_t Channel, uint16_t Value);
+void PCA9685_CHAIN_SetChannels(uint16_t FirstChannel, uint16_t Count, const uint16_t* Values);
+uint16_t PCA9685_CHAIN_GetChannel(uint16_t Channel);
+void PCA9685_CHAIN_SetGroup(uint16_t Channel, uint8_t Group);
+void PCA9685_CHAIN_SetGroupBrightness(uint8_t Group, uint8_t Brightness);
+uint8_t PCA9685_CHAIN_UpdatePending();
+void PCA9685_CHAIN_Update();
+
+#endif /* PCA9685_CHAIN_H_ */
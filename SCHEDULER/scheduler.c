@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file	scheduler.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions for a cooperative task scheduler
+ *			- Static task table with periodic and one-shot tasks
+ *			- Priorities and deadlines
+ *			- Worst-case runtime and overrun statistics per task
+ *			- Puts the CPU to sleep with MILLIS_COUNT_SleepUntil when no task
+ *			  is due. In normal mode this is idle sleep and the TIMER1
+ *			  interrupt wakes it up every millisecond, in tickless mode the
+ *			  CPU stays in power-save until the next task is due.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <assert/assert.h>
+#include <MILLIS_COUNT/millis_count.h>
+#include "scheduler.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TASK_ACTIVE		0x01
+#define TASK_ONE_SHOT	0x02
+// Cleared if the task is removed while it runs, the slot can then belong to a new task
+#define TASK_RUNNING	0x04
+
+// Time comparison that survives the wrap of the millisecond counter
+#define TIME_REACHED(NOW, TIME)	((int32_t)((NOW) - (TIME)) >= 0)
+
+/* Private typedefs ----------------------------------------------------------*/
+typedef struct
+{
+	SCHEDULER_Function_TypeDef function;
+	uint32_t nextRun;
+	uint16_t period;
+	uint16_t deadline;
+	uint8_t priority;
+	uint8_t flags;
+	SCHEDULER_TaskStats_TypeDef stats;
+} Task_TypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+Task_TypeDef _schedulerTasks[SCHEDULER_MAX_TASKS];
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t addTask(SCHEDULER_Function_TypeDef Function, uint32_t FirstRun, uint16_t Period,
+					uint16_t Deadline, uint8_t Priority, uint8_t Flags);
+static uint8_t getNextTask(uint32_t Now);
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes the scheduler and MILLIS_COUNT if it is not already initialized
+ * @param	None
+ * @retval	None
+ */
+void SCHEDULER_Init()
+{
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+	
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+		_schedulerTasks[i].flags = 0;
+}
+
+/**
+ * @brief	Adds a task that will run every [Period] ms
+ * @param	Function: The function to run
+ * @param	Period: Time in ms between each run
+ * @param	Offset: Time in ms until the first run, can be used to spread out tasks with the same period
+ * @param	Deadline: Time in ms from release until the task must be done, 0 will use Period
+ * @param	Priority: Priority of the task, SCHEDULER_PRIORITY_HIGHEST (0) is run first
+ * @retval	Id of the task
+ * @retval	SCHEDULER_NO_TASK: The task table is full
+ */
+uint8_t SCHEDULER_AddPeriodicTask(SCHEDULER_Function_TypeDef Function, uint16_t Period, uint16_t Offset,
+								uint16_t Deadline, uint8_t Priority)
+{
+	assert_param(Period != 0);
+	if (!Deadline) Deadline = Period;
+	return addTask(Function, millis() + Offset, Period, Deadline, Priority, TASK_ACTIVE);
+}
+
+/**
+ * @brief	Adds a task that will run once after [Delay] ms
+ * @param	Function: The function to run
+ * @param	Delay: Time in ms until the task is run
+ * @param	Deadline: Time in ms from release until the task must be done, 0 for no deadline
+ * @param	Priority: Priority of the task, SCHEDULER_PRIORITY_HIGHEST (0) is run first
+ * @retval	Id of the task
+ * @retval	SCHEDULER_NO_TASK: The task table is full
+ * @note	Can be called from an ISR to defer work to the main loop
+ */
+uint8_t SCHEDULER_AddOneShotTask(SCHEDULER_Function_TypeDef Function, uint16_t Delay,
+								uint16_t Deadline, uint8_t Priority)
+{
+	return addTask(Function, millis() + Delay, 0, Deadline, Priority, TASK_ACTIVE | TASK_ONE_SHOT);
+}
+
+/**
+ * @brief	Removes a task from the scheduler
+ * @param	TaskId: Id of the task to remove
+ * @retval	None
+ */
+void SCHEDULER_RemoveTask(uint8_t TaskId)
+{
+	if (IS_SCHEDULER_TASK_ID(TaskId))
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			_schedulerTasks[TaskId].flags = 0;
+		}
+	}
+}
+
+/**
+ * @brief	Runs the highest priority task that is due. Puts the CPU to sleep
+ *			if no task is due.
+ * @param	None
+ * @retval	None
+ * @note	Call this repeatedly from the main loop
+ */
+void SCHEDULER_Dispatch()
+{
+	uint32_t now = millis();
+	uint8_t taskId = getNextTask(now);
+	
+	if (taskId == SCHEDULER_NO_TASK)
+	{
+		MILLIS_COUNT_SleepUntil(SCHEDULER_NextDueMillis());
+		return;
+	}
+	
+	Task_TypeDef* task = &_schedulerTasks[taskId];
+	uint32_t release = task->nextRun;
+	
+	// Release the next instance before running so the task can remove itself
+	if (!(task->flags & TASK_ONE_SHOT))
+	{
+		task->nextRun += task->period;
+		// Releases that were missed completely are counted as overruns
+		while (TIME_REACHED(now, task->nextRun))
+		{
+			task->nextRun += task->period;
+			task->stats.overrunCount++;
+		}
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		task->flags |= TASK_RUNNING;
+	}
+	
+	uint32_t startMicros = micros();
+	task->function();
+	uint32_t runtime = micros() - startMicros;
+	
+	// A one-shot task keeps its slot until here so an ISR can not reuse it
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (task->flags & TASK_RUNNING)
+		{
+			if (runtime > task->stats.worstCaseRuntime)
+				task->stats.worstCaseRuntime = runtime;
+			task->stats.runCount++;
+			if (task->deadline && !TIME_REACHED(release + task->deadline, millis()))
+				task->stats.overrunCount++;
+			
+			if (task->flags & TASK_ONE_SHOT)
+				task->flags = 0;
+			else
+				task->flags &= ~TASK_RUNNING;
+		}
+	}
+}
+
+/**
+ * @brief	Runs the scheduler forever
+ * @param	None
+ * @retval	None
+ */
+void SCHEDULER_Run()
+{
+	while (1)
+	{
+		SCHEDULER_Dispatch();
+	}
+}
+
+/**
+ * @brief	Gets the time for when the next task is due
+ * @param	None
+ * @retval	The millis() value when the next task should run. If no task is
+ *			active the time one minute from now is returned.
+ */
+uint32_t SCHEDULER_NextDueMillis()
+{
+	uint32_t now = millis();
+	uint32_t nextDue = now + 60000;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+		{
+			if ((_schedulerTasks[i].flags & TASK_ACTIVE) && 
+				(int32_t)(_schedulerTasks[i].nextRun - nextDue) < 0)
+				nextDue = _schedulerTasks[i].nextRun;
+		}
+	}
+	return nextDue;
+}
+
+/**
+ * @brief	Gets the runtime statistics for a task
+ * @param	TaskId: Id of the task
+ * @param	Stats: Pointer to where the statistics should be stored
+ * @retval	1: Statistics copied
+ * @retval	0: Invalid task id
+ */
+uint8_t SCHEDULER_GetTaskStats(uint8_t TaskId, SCHEDULER_TaskStats_TypeDef* Stats)
+{
+	if (IS_SCHEDULER_TASK_ID(TaskId))
+	{
+		*Stats = _schedulerTasks[TaskId].stats;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief	Resets the runtime statistics for a task
+ * @param	TaskId: Id of the task
+ * @retval	None
+ */
+void SCHEDULER_ResetTaskStats(uint8_t TaskId)
+{
+	if (IS_SCHEDULER_TASK_ID(TaskId))
+	{
+		_schedulerTasks[TaskId].stats.worstCaseRuntime = 0;
+		_schedulerTasks[TaskId].stats.runCount = 0;
+		_schedulerTasks[TaskId].stats.overrunCount = 0;
+	}
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Puts a task in the first free slot of the task table
+ * @param	Function: The function to run
+ * @param	FirstRun: millis() value for the first run
+ * @param	Period: Time in ms between each run, 0 for one-shot tasks
+ * @param	Deadline: Time in ms from release until the task must be done
+ * @param	Priority: Priority of the task
+ * @param	Flags: TASK_ACTIVE and optionally TASK_ONE_SHOT
+ * @retval	Id of the task or SCHEDULER_NO_TASK if the table is full
+ */
+static uint8_t addTask(SCHEDULER_Function_TypeDef Function, uint32_t FirstRun, uint16_t Period,
+					uint16_t Deadline, uint8_t Priority, uint8_t Flags)
+{
+	assert_param(Function != 0);
+	
+	uint8_t taskId = SCHEDULER_NO_TASK;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+		{
+			if (!(_schedulerTasks[i].flags & TASK_ACTIVE))
+			{
+				Task_TypeDef* task = &_schedulerTasks[i];
+				task->function = Function;
+				task->nextRun = FirstRun;
+				task->period = Period;
+				task->deadline = Deadline;
+				task->priority = Priority;
+				task->stats.worstCaseRuntime = 0;
+				task->stats.runCount = 0;
+				task->stats.overrunCount = 0;
+				task->flags = Flags;
+				taskId = i;
+				break;
+			}
+		}
+	}
+	return taskId;
+}
+
+/**
+ * @brief	Finds the task that should run next. Among the due tasks the one with
+ *			highest priority is chosen, and for equal priority the one with the
+ *			earliest release.
+ * @param	Now: Current millis() value
+ * @retval	Id of the task or SCHEDULER_NO_TASK if no task is due
+ */
+static uint8_t getNextTask(uint32_t Now)
+{
+	uint8_t taskId = SCHEDULER_NO_TASK;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+		{
+			Task_TypeDef* task = &_schedulerTasks[i];
+			if (!(task->flags & TASK_ACTIVE) || !TIME_REACHED(Now, task->nextRun))
+				continue;
+			
+			if (taskId == SCHEDULER_NO_TASK ||
+				task->priority < _schedulerTasks[taskId].priority ||
+				(task->priority == _schedulerTasks[taskId].priority &&
+				(int32_t)(task->nextRun - _schedulerTasks[taskId].nextRun) < 0))
+				taskId = i;
+		}
+	}
+	return taskId;
+}
+
+/* Interrupt Service Routines ------------------------------------------------*/
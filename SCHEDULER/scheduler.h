@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * @file	scheduler.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains typedefs and function prototypes for a cooperative task
+ *			scheduler that uses MILLIS_COUNT as timebase
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Defines -------------------------------------------------------------------*/
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS			8
+#endif
+
+#define SCHEDULER_NO_TASK			0xFF
+#define SCHEDULER_PRIORITY_HIGHEST	0
+#define SCHEDULER_PRIORITY_LOWEST	0xFF
+
+#define IS_SCHEDULER_TASK_ID(ID)	((ID) < SCHEDULER_MAX_TASKS)
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief	Typedef for a pointer to a function that is run by the scheduler
+ */
+typedef void (*SCHEDULER_Function_TypeDef)(void);
+
+/**
+ * @brief	Runtime statistics for a task
+ */
+typedef struct
+{
+	uint32_t worstCaseRuntime;	/** Longest time the task has been running, in microseconds */
+	uint16_t runCount;			/** Number of times the task has been run */
+	uint16_t overrunCount;		/** Number of times the task finished after its deadline or missed a release */
+} SCHEDULER_TaskStats_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void SCHEDULER_Init();
+uint8_t SCHEDULER_AddPeriodicTask(SCHEDULER_Function_TypeDef Function, uint16_t Period, uint16_t Offset,
+								uint16_t Deadline, uint8_t Priority);
+uint8_t SCHEDULER_AddOneShotTask(SCHEDULER_Function_TypeDef Function, uint16_t Delay,
+								uint16_t Deadline, uint8_t Priority);
+void SCHEDULER_RemoveTask(uint8_t TaskId);
+
+void SCHEDULER_Dispatch();
+void SCHEDULER_Run();
+uint32_t SCHEDULER_NextDueMillis();
+
+uint8_t SCHEDULER_GetTaskStats(uint8_t TaskId, SCHEDULER_TaskStats_TypeDef* Stats);
+void SCHEDULER_ResetTaskStats(uint8_t TaskId);
+
+#endif /* SCHEDULER_H_ */
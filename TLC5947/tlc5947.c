@@ -10,71 +10,286 @@
  
 /* Includes ------------------------------------------------------------------*/
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
 #include <util/delay.h>
 #include <DELAY_VAR/delayVar.h>
 #include <atmega328x/spi.h>
-#include <COLOR _16_BIT/color_16_bit.h>
+#include <COLOR/color.h>
+#include <assert/assert.h>
 #include "tlc5947.h"
+#if TLC5947_FRAME_TIME > 0
+#include <MILLIS_COUNT/millis_count.h>
+#endif
 
 /* Private defines -----------------------------------------------------------*/
+/*
+ * Order of the colors on the three outputs of a pixel, resolved at compile
+ * time. COLOR_n picks the value for output 3*pixel + n.
+ */
+#if defined(TLC5947_BRG_ORDER)
+#define COLOR_0(R, G, B)	(B)
+#define COLOR_1(R, G, B)	(R)
+#define COLOR_2(R, G, B)	(G)
+#elif defined(TLC5947_GRB_ORDER)
+#define COLOR_0(R, G, B)	(G)
+#define COLOR_1(R, G, B)	(R)
+#define COLOR_2(R, G, B)	(B)
+#else
+#define COLOR_0(R, G, B)	(R)
+#define COLOR_1(R, G, B)	(G)
+#define COLOR_2(R, G, B)	(B)
+#endif
+
+#define BYTES_PER_MODULE	72
+
+/*
+ * Output 47 is shifted out first. Outputs 2n and 2n+1 share three bytes
+ * starting at PAIR_OFFSET(n): [2n+1 bit 11-4] [2n+1 bit 3-0, 2n bit 11-8] [2n bit 7-0]
+ */
+#define PAIR_OFFSET(PAIR)	(BYTES_PER_MODULE - 3 - 3*(PAIR))
+
+#define OUTPUTS_PER_MODULE	48
+
+#ifdef TLC5947_CORRECTION
+/*
+ * Scales a value with the combined correction and brightness of an output.
+ * The scale is correction * brightness stretched from 0-65025 to 0-65535, so
+ * 0 for either turns the output off and 255 for both gives back the value
+ * unchanged.
+ */
+#define CORRECT(MODULE, OUTPUT, VALUE)	(uint16_t)(((uint32_t)(VALUE) * _tlc5947Scale[MODULE][OUTPUT] + (VALUE)) >> 16)
+#endif
+
 /* Private variables ---------------------------------------------------------*/
-uint8_t _tlc5947Data[NUM_OF_MODULES][72];
+#ifdef TLC5947_DOUBLE_BUFFER
+/*
+ * _tlc5947Data points to the back buffer that the set functions write to. The
+ * other buffer is the front buffer, it is streamed out by SPI_STC_vect and
+ * must not be changed until _tlc5947Busy is cleared.
+ */
+uint8_t _tlc5947Buffer[2][NUM_OF_MODULES][BYTES_PER_MODULE];
+uint8_t (*_tlc5947Data)[BYTES_PER_MODULE] = _tlc5947Buffer[0];
+const uint8_t* volatile _tlc5947TxPointer;
+const uint8_t* _tlc5947TxEnd;
+volatile uint8_t _tlc5947Busy;
+#else
+uint8_t _tlc5947Data[NUM_OF_MODULES][BYTES_PER_MODULE];
+#endif
+
+#ifdef TLC5947_CORRECTION
+// The values from the set functions before correction, packed the same way as _tlc5947Data
+uint8_t _tlc5947Raw[NUM_OF_MODULES][BYTES_PER_MODULE];
+uint8_t _tlc5947Correction[NUM_OF_MODULES][OUTPUTS_PER_MODULE];
+uint16_t _tlc5947Scale[NUM_OF_MODULES][OUTPUTS_PER_MODULE];
+uint8_t _tlc5947Brightness;
+#endif
+
+// Non-zero when _tlc5947Data has changed since it was last shifted out
+uint8_t _tlc5947Dirty;
+#if TLC5947_FRAME_TIME > 0
+uint32_t _tlc5947LastLatch;
+#endif
 
 /* Private functions ---------------------------------------------------------*/
 /**
- * @brief	Sets the correct value in the array based on which output should be changed.
- *			Outputs are 12bit values but the array only holds 8bit values so we need to move stuff around a bit
+ * @brief	Writes two 12-bit outputs into their three bytes. This is the kernel
+ *			for all the bulk functions, there are no branches and the change
+ *			check is a couple of XOR.
+ * @param	Dst: Pointer to the first of the three bytes, see PAIR_OFFSET
+ * @param	Even: Value for the even output of the pair
+ * @param	Odd: Value for the odd output of the pair
+ * @retval	Non-zero if any byte changed
+ */
+static inline uint8_t writePair(uint8_t* Dst, const uint16_t Even, const uint16_t Odd)
+{
+	uint8_t b0 = Odd >> 4;
+	uint8_t b1 = (uint8_t)(Odd << 4) | ((Even >> 8) & 0x0F);
+	uint8_t b2 = Even;
+	uint8_t changed = (Dst[0] ^ b0) | (Dst[1] ^ b1) | (Dst[2] ^ b2);
+	Dst[0] = b0;
+	Dst[1] = b1;
+	Dst[2] = b2;
+	return changed;
+}
+
+/**
+ * @brief	Writes the even output of a pair and keeps the odd one
+ * @param	Dst: Pointer to the first of the three bytes, see PAIR_OFFSET
+ * @param	Even: Value for the even output of the pair
+ * @retval	Non-zero if any byte changed
+ */
+static inline uint8_t writeEven(uint8_t* Dst, const uint16_t Even)
+{
+	uint8_t b1 = (Dst[1] & 0xF0) | ((Even >> 8) & 0x0F);
+	uint8_t b2 = Even;
+	uint8_t changed = (Dst[1] ^ b1) | (Dst[2] ^ b2);
+	Dst[1] = b1;
+	Dst[2] = b2;
+	return changed;
+}
+
+/**
+ * @brief	Writes the odd output of a pair and keeps the even one
+ * @param	Dst: Pointer to the first of the three bytes, see PAIR_OFFSET
+ * @param	Odd: Value for the odd output of the pair
+ * @retval	Non-zero if any byte changed
+ */
+static inline uint8_t writeOdd(uint8_t* Dst, const uint16_t Odd)
+{
+	uint8_t b0 = Odd >> 4;
+	uint8_t b1 = (uint8_t)(Odd << 4) | (Dst[1] & 0x0F);
+	uint8_t changed = (Dst[0] ^ b0) | (Dst[1] ^ b1);
+	Dst[0] = b0;
+	Dst[1] = b1;
+	return changed;
+}
+
+/**
+ * @brief	Packs an output pair of a module, with TLC5947_CORRECTION the raw
+ *			values are kept and the corrected values are shifted out
+ * @param	Module: The module
+ * @param	Pair: Output pair, outputs 2*pair and 2*pair+1
+ * @param	Even: Value for the even output of the pair
+ * @param	Odd: Value for the odd output of the pair
+ * @retval	None
+ */
+static inline void packPair(const uint8_t Module, const uint8_t Pair, uint16_t Even, uint16_t Odd)
+{
+#ifdef TLC5947_CORRECTION
+	writePair(&_tlc5947Raw[Module][PAIR_OFFSET(Pair)], Even, Odd);
+	Even = CORRECT(Module, 2*Pair, Even);
+	Odd = CORRECT(Module, 2*Pair + 1, Odd);
+#endif
+	_tlc5947Dirty |= writePair(&_tlc5947Data[Module][PAIR_OFFSET(Pair)], Even, Odd);
+}
+
+/**
+ * @brief	Packs the even output of a pair and keeps the odd one
+ * @param	Module: The module
+ * @param	Pair: Output pair, outputs 2*pair and 2*pair+1
+ * @param	Even: Value for the even output of the pair
+ * @retval	None
+ */
+static inline void packEven(const uint8_t Module, const uint8_t Pair, uint16_t Even)
+{
+#ifdef TLC5947_CORRECTION
+	writeEven(&_tlc5947Raw[Module][PAIR_OFFSET(Pair)], Even);
+	Even = CORRECT(Module, 2*Pair, Even);
+#endif
+	_tlc5947Dirty |= writeEven(&_tlc5947Data[Module][PAIR_OFFSET(Pair)], Even);
+}
+
+/**
+ * @brief	Packs the odd output of a pair and keeps the even one
+ * @param	Module: The module
+ * @param	Pair: Output pair, outputs 2*pair and 2*pair+1
+ * @param	Odd: Value for the odd output of the pair
+ * @retval	None
+ */
+static inline void packOdd(const uint8_t Module, const uint8_t Pair, uint16_t Odd)
+{
+#ifdef TLC5947_CORRECTION
+	writeOdd(&_tlc5947Raw[Module][PAIR_OFFSET(Pair)], Odd);
+	Odd = CORRECT(Module, 2*Pair + 1, Odd);
+#endif
+	_tlc5947Dirty |= writeOdd(&_tlc5947Data[Module][PAIR_OFFSET(Pair)], Odd);
+}
+
+/**
+ * @brief	Sets the value of a single output
  * @param	output: The output to set
  * @param	module: The module to set
  * @param	value: The value to set
  * @retval	None
  */
 static void setOutputValue(uint8_t output, const uint8_t module, uint16_t value) {
-  // Inverse the output
-  output = 47 - output;
-  
-  /* #1 Example: output = 3: 3*12=36, 36/8=4.5=4 -> Byte no 4 is the start
-        Example: output = 2: 2*12=24, 24/8=3 -> Byte no 3 is the start
-  */
-    uint8_t positionInArray = output*12/8;
-  
-  /* If the output is uneven the 4 MSB-bits starts on the current byte */
-  if (output % 2) {    
-    // #2 Put the 8 LSB-bits in the whole next position in the array
-    _tlc5947Data[module][positionInArray+1] = value & 0xFF;
-    // #3 Shift forward to the 4 MSB-bits
-    value = value >> 8;
-    /* #4 Put the 4 MSB-bits in half the calculated position in the array
-          They must be in the 4 LSB-bits in this byte so no shift required
-          The oldData must be combined with the new, so extract the old and then combine
-    */
-    uint8_t oldData =  _tlc5947Data[module][positionInArray];
-    _tlc5947Data[module][positionInArray] = (oldData & 0xF0) | (value & 0xF);
-  }
-  /* If the output is even the 4 LSB-bits starts on the next byte */
-  else {    
-    /* #2 Put the 4 LSB-bits in half the next position in the array.
-          They must be in the 4 MSB-bits in this byte so bitshift left 4 steps
-    */
-    uint8_t oldData =  _tlc5947Data[module][positionInArray+1];
-    _tlc5947Data[module][positionInArray+1] = ((value & 0xF) << 4) | (oldData & 0xF);
-    // #3 Shift forward to the 8 MSB-bits
-    value = value >> 4;
-    // #4 Put the 8 MSB-bits in the whole calculated position in the array
-    _tlc5947Data[module][positionInArray] = value & 0xFF;
-  }
-}
-
-/**
- * @brief	Updates the output by writing to the LED drivers
+	if (output & 1) packOdd(module, output >> 1, value);
+	else packEven(module, output >> 1, value);
+}
+
+/**
+ * @brief	Packs two neighbouring pixels, 2*pair and 2*pair+1, which cover
+ *			three whole output pairs
+ * @param	Module: The module
+ * @param	Pair: Pixel pair in the module, 0-7
+ * @param	First: RGB for the first pixel
+ * @param	Second: RGB for the second pixel
+ * @retval	None
+ */
+static inline void packPixelPair(const uint8_t Module, const uint8_t Pair, const uint16_t* First, const uint16_t* Second)
+{
+	// Outputs 6*pair to 6*pair+5 are output pairs 3*pair to 3*pair+2
+	uint8_t outputPair = 3*Pair;
+	packPair(Module, outputPair, COLOR_0(First[0], First[1], First[2]), COLOR_1(First[0], First[1], First[2]));
+	packPair(Module, outputPair + 1, COLOR_2(First[0], First[1], First[2]), COLOR_0(Second[0], Second[1], Second[2]));
+	packPair(Module, outputPair + 2, COLOR_1(Second[0], Second[1], Second[2]), COLOR_2(Second[0], Second[1], Second[2]));
+}
+
+#ifdef TLC5947_CORRECTION
+/**
+ * @brief	Calculates the scale for an output from its correction and the
+ *			global brightness
+ * @param	Module: The module
+ * @param	Output: The output
+ * @retval	None
+ */
+static void updateScale(const uint8_t Module, const uint8_t Output)
+{
+	uint16_t scale = (uint16_t)_tlc5947Correction[Module][Output] * _tlc5947Brightness;
+	_tlc5947Scale[Module][Output] = scale + 2 * (scale / 255);
+}
+
+/**
+ * @brief	Packs an output pair again from the raw values with the current scales
+ * @param	Module: The module
+ * @param	Pair: Output pair, outputs 2*pair and 2*pair+1
+ * @retval	None
+ */
+static void repackPair(const uint8_t Module, const uint8_t Pair)
+{
+	const uint8_t* raw = &_tlc5947Raw[Module][PAIR_OFFSET(Pair)];
+	uint16_t odd = ((uint16_t)raw[0] << 4) | (raw[1] >> 4);
+	uint16_t even = ((uint16_t)(raw[1] & 0x0F) << 8) | raw[2];
+	_tlc5947Dirty |= writePair(&_tlc5947Data[Module][PAIR_OFFSET(Pair)],
+								CORRECT(Module, 2*Pair, even), CORRECT(Module, 2*Pair + 1, odd));
+}
+#endif
+
+/**
+ * @brief	Updates the output by writing to the LED drivers. Nothing is sent if
+ *			no value has changed since the last update.
  * @param	None
  * @retval	None
  */
 static void updateOutputs() {
+	if (!_tlc5947Dirty) return;
+#ifdef TLC5947_DOUBLE_BUFFER
+	// The front buffer can only be swapped when the last frame is done
+	while (_tlc5947Busy);
+#endif
+	_tlc5947Dirty = 0;
+#if TLC5947_FRAME_TIME > 0
+	_tlc5947LastLatch = millis();
+#endif
+	
+#ifdef TLC5947_DOUBLE_BUFFER
+	// Swap and start the stream, the rest is sent and latched by SPI_STC_vect
+	uint8_t (*front)[BYTES_PER_MODULE] = _tlc5947Data;
+	_tlc5947Data = (front == _tlc5947Buffer[0]) ? _tlc5947Buffer[1] : _tlc5947Buffer[0];
+	
+	// The set functions change single values so the back buffer must start as the shown frame
+	memcpy(_tlc5947Data, front, sizeof(_tlc5947Buffer[0]));
+	
+	_tlc5947TxPointer = &front[0][1];
+	_tlc5947TxEnd = &front[0][0] + sizeof(_tlc5947Buffer[0]);
+	_tlc5947Busy = 1;
+	SPDR = front[0][0];
+#else
 	uint8_t byte, module;
 	for (module = 0; module < NUM_OF_MODULES; module++) {
 		for (byte = 0; byte < 72; byte++) {    
-			spiWrite(_tlc5947Data[module][byte]);
+			SPI_Write(_tlc5947Data[module][byte]);
 		}
 	}
 	//_delay_ms(2000);
@@ -88,6 +303,7 @@ static void updateOutputs() {
 	//_delay_ms(2000);
 	OUTPUT_ON;
 	//_delay_ms(2000);
+#endif
 }
 
 /* Functions -----------------------------------------------------------------*/
@@ -104,16 +320,89 @@ void TLC5947_Init()
 	/*_delay_ms(2000);*/
 	OUTPUT_OFF;
 	/*_delay_ms(2000);*/
- 	spiSetup(SPI_CLOCK_DIV2);
+	SPI_InitTypeDef spiInit;
+	spiInit.SPI_Clock = TLC5947_SPI_CLOCK;
+	SPI_Init(&spiInit);
+#ifdef TLC5947_DOUBLE_BUFFER
+	SPCR |= (1 << SPIE);
+	sei();
+#endif
+#if TLC5947_FRAME_TIME > 0
+	if (!MILLIS_COUNT_Initialized())
+		MILLIS_COUNT_Init();
+#endif
 	/*_delay_ms(2000);*/
  	LATCH_LOW;
 	/*_delay_ms(2000);*/
+#ifdef TLC5947_CORRECTION
+	_tlc5947Brightness = 255;
+	for (uint8_t module = 0; module < NUM_OF_MODULES; module++)
+	{
+		for (uint8_t output = 0; output < OUTPUTS_PER_MODULE; output++)
+		{
+			_tlc5947Correction[module][output] = 255;
+			updateScale(module, output);
+		}
+	}
+#endif
+	// Make sure the first clear is sent whatever the array contains
+	_tlc5947Dirty = 1;
 	tlc5947clearAll();
+#ifdef TLC5947_DOUBLE_BUFFER
+	while (_tlc5947Busy);
+#endif
 	/*_delay_ms(2000);*/
 	OUTPUT_OFF;
 	/*_delay_ms(2000);*/
 }
 
+/**
+ * @brief	Latches the values set since the last update to the outputs. Nothing
+ *			is sent if no value has changed. With TLC5947_FRAME_TIME the update
+ *			is also held back until that many ms have passed since the last
+ *			latch, so several calls are merged into one frame.
+ * @param	None
+ * @retval	None
+ * @note	With TLC5947_FRAME_TIME a held back update is only sent on a later
+ *			call, so keep calling this from the main loop. The same goes for
+ *			TLC5947_DOUBLE_BUFFER while the last frame is still streaming.
+ */
+void tlc5947update()
+{
+#ifdef TLC5947_DOUBLE_BUFFER
+	if (_tlc5947Busy) return;
+#endif
+#if TLC5947_FRAME_TIME > 0
+	if ((uint32_t)(millis() - _tlc5947LastLatch) < TLC5947_FRAME_TIME) return;
+#endif
+	updateOutputs();
+}
+
+/**
+ * @brief	Checks if there are values that have not been latched yet
+ * @param	None
+ * @retval	1 if an update is pending, otherwise 0
+ */
+uint8_t tlc5947updatePending()
+{
+	return (_tlc5947Dirty != 0);
+}
+
+/**
+ * @brief	Checks if a frame is being streamed to the LED drivers
+ * @param	None
+ * @retval	1 if streaming, otherwise 0
+ * @note	Always 0 without TLC5947_DOUBLE_BUFFER
+ */
+uint8_t tlc5947isBusy()
+{
+#ifdef TLC5947_DOUBLE_BUFFER
+	return _tlc5947Busy;
+#else
+	return 0;
+#endif
+}
+
 /**
  * @brief	Clears all the outputs back to 0x000
  * @param	None
@@ -132,33 +421,33 @@ void tlc5947clearAll() {
  */
 void tlc5947setPixelRGB(const uint8_t pixel, const uint8_t module, const uint16_t red, const uint16_t green, const uint16_t blue)
 {
-  uint8_t baseOutput = pixel * 3;
-  
-  #ifdef TLC5947_BRG_ORDER
-	  setOutputValue(baseOutput, module, blue);
-	  setOutputValue(baseOutput + 1, module, red);
-	  setOutputValue(baseOutput + 2, module, green);
-  #elif defined TLC5947_GRB_ORDER
- 	  setOutputValue(baseOutput, module, green);
- 	  setOutputValue(baseOutput + 1, module, red);
- 	  setOutputValue(baseOutput + 2, module, blue);
-  #else
-	  setOutputValue(baseOutput, module, red);
-	  setOutputValue(baseOutput + 1, module, green);
-	  setOutputValue(baseOutput + 2, module, blue);
-  #endif
+	// Outputs 3*pixel to 3*pixel+2 are one whole output pair and half of another
+	uint8_t pair = (pixel * 3) >> 1;
+	
+	if (pixel & 1)
+	{
+		packOdd(module, pair, COLOR_0(red, green, blue));
+		packPair(module, pair + 1, COLOR_1(red, green, blue), COLOR_2(red, green, blue));
+	}
+	else
+	{
+		packPair(module, pair, COLOR_0(red, green, blue), COLOR_1(red, green, blue));
+		packEven(module, pair + 1, COLOR_2(red, green, blue));
+	}
 }
 
 /**
- * @brief	...
+ * @brief	Sets a pixel of one serpentine wired 4x4 module, x is the line and
+ *			y the position in the line. See tlc5947_map.h for panels of several
+ *			modules and other wirings.
  * @param	...
  * @retval	...
  */
 void tlc5947setPixelRGBxy(const uint8_t x, const uint8_t y, const uint8_t module, 
 					const uint16_t red, const uint16_t green, const uint16_t blue)
 {
-	uint8_t pixelTransform[4][4] = { {0, 1, 2, 3}, {7, 6, 5, 4}, {8, 9, 10, 11}, {15, 14, 13, 12} };
-	tlc5947setPixelRGB(pixelTransform[x][y], module, red, green, blue);
+	uint8_t pixel = x * 4 + ((x & 1) ? 3 - y : y);
+	tlc5947setPixelRGB(pixel, module, red, green, blue);
 }
 
 /**
@@ -167,15 +456,120 @@ void tlc5947setPixelRGBxy(const uint8_t x, const uint8_t y, const uint8_t module
  * @retval	...
  */
 void tlc5947setAllRGB(const uint16_t red, const uint16_t green, const uint16_t blue) {
-  uint8_t pixel, module;
-  
-  for (module = 0; module < NUM_OF_MODULES; module++) {
-    for (pixel = 0; pixel < NUM_OF_PIXELS ; pixel++) {
-      tlc5947setPixelRGB(pixel, module, red, green, blue);
-    }
-  }
+	uint16_t color[3] = {red, green, blue};
+	
+	for (uint8_t module = 0; module < NUM_OF_MODULES; module++)
+	{
+		for (uint8_t pair = 0; pair < NUM_OF_PIXELS/2; pair++)
+			packPixelPair(module, pair, color, color);
+	}
 }
 
+/**
+ * @brief	Sets the RGB values of many pixels at once, starting at pixel 0 of
+ *			module 0 and continuing into the next modules
+ * @param	rgb: Red, green and blue 12-bit values for each pixel, 3*count values
+ * @param	count: Number of pixels to set, at most TOTAL_OF_PIXELS
+ * @retval	None
+ */
+void tlc5947setFrame(const uint16_t* rgb, uint16_t count)
+{
+	if (count > TOTAL_OF_PIXELS) count = TOTAL_OF_PIXELS;
+	
+	uint8_t module = 0;
+	uint8_t pair = 0;
+	for (; count >= 2; count -= 2, rgb += 6)
+	{
+		packPixelPair(module, pair, rgb, rgb + 3);
+		if (++pair == NUM_OF_PIXELS/2)
+		{
+			pair = 0;
+			module++;
+		}
+	}
+	
+	if (count)
+		tlc5947setPixelRGB(pair * 2, module, rgb[0], rgb[1], rgb[2]);
+}
+
+#ifdef TLC5947_CORRECTION
+/**
+ * @brief	Sets the global brightness. The outputs are packed again from the
+ *			values last set so there is no need to set the frame again.
+ * @param	brightness: 0-255, 255 is full brightness
+ * @retval	None
+ */
+void tlc5947setBrightness(const uint8_t brightness)
+{
+	if (brightness == _tlc5947Brightness) return;
+	
+	_tlc5947Brightness = brightness;
+	for (uint8_t module = 0; module < NUM_OF_MODULES; module++)
+	{
+		for (uint8_t output = 0; output < OUTPUTS_PER_MODULE; output++)
+			updateScale(module, output);
+		for (uint8_t pair = 0; pair < OUTPUTS_PER_MODULE/2; pair++)
+			repackPair(module, pair);
+	}
+}
+
+/**
+ * @brief	Returns the global brightness
+ * @param	None
+ * @retval	The brightness, 0-255
+ */
+uint8_t tlc5947getBrightness()
+{
+	return _tlc5947Brightness;
+}
+
+/**
+ * @brief	Sets the correction of a single output, used to match LEDs with
+ *			different efficiency or current
+ * @param	output: The output, 0-47
+ * @param	module: The module
+ * @param	correction: 0-255, 255 leaves the output unchanged
+ * @retval	None
+ */
+void tlc5947setCorrection(const uint8_t output, const uint8_t module, const uint8_t correction)
+{
+	assert_param(output < OUTPUTS_PER_MODULE && module < NUM_OF_MODULES);
+	if (output >= OUTPUTS_PER_MODULE || module >= NUM_OF_MODULES) return;
+	
+	_tlc5947Correction[module][output] = correction;
+	updateScale(module, output);
+	repackPair(module, output >> 1);
+}
+
+/**
+ * @brief	Sets the correction of the red, green and blue outputs of all pixels
+ *			of a module, used for the white balance of a module
+ * @param	module: The module
+ * @param	red: Correction for red, 0-255
+ * @param	green: Correction for green, 0-255
+ * @param	blue: Correction for blue, 0-255
+ * @retval	None
+ */
+void tlc5947setModuleCorrection(const uint8_t module, const uint8_t red, const uint8_t green, const uint8_t blue)
+{
+	assert_param(module < NUM_OF_MODULES);
+	if (module >= NUM_OF_MODULES) return;
+	
+	for (uint8_t output = 0; output < OUTPUTS_PER_MODULE; output += 3)
+	{
+		_tlc5947Correction[module][output] = COLOR_0(red, green, blue);
+		_tlc5947Correction[module][output + 1] = COLOR_1(red, green, blue);
+		_tlc5947Correction[module][output + 2] = COLOR_2(red, green, blue);
+		updateScale(module, output);
+		updateScale(module, output + 1);
+		updateScale(module, output + 2);
+	}
+	
+	for (uint8_t pair = 0; pair < OUTPUTS_PER_MODULE/2; pair++)
+		repackPair(module, pair);
+}
+#endif
+
 /**
  * @brief	...
  * @param	...
@@ -197,7 +591,7 @@ void tlc5947testHUEAll(const uint16_t delayTime)
 	uint16_t hue, red, green, blue;
 	for (hue = 0; hue < 360; hue++) 
 	{
-		HSBtoRGB(hue, 100, 100, &red, &green, &blue, 12);
+		HSBtoRGB12(hue, 100, 100, &red, &green, &blue);
 		tlc5947setAllRGB(red, green, blue);
 		updateOutputs();
 		delay_ms(delayTime);
@@ -216,7 +610,7 @@ void tlc5947testHUESeperate(uint16_t delayTime) {
 	for (module = 0; module < NUM_OF_MODULES; module++) {
 		for (pixel = 0; pixel < NUM_OF_PIXELS; pixel++) {
 			hue = 360/TOTAL_OF_PIXELS * (module*NUM_OF_PIXELS + pixel);
-			HSBtoRGB(hue, 100, 100, &red, &green, &blue, 12);
+			HSBtoRGB12(hue, 100, 100, &red, &green, &blue);
 			tlc5947setPixelRGB(pixel, module, red, green, blue);
 			
 			updateOutputs();
@@ -241,7 +635,7 @@ void tlc5947testHUESeperateMoving(uint16_t delayTime) {
 		for (module = 0; module < NUM_OF_MODULES; module++) {
 			for (pixel = 0; pixel < NUM_OF_PIXELS; pixel++) {
 				hue = 360/TOTAL_OF_PIXELS * (module*NUM_OF_PIXELS + pixel);
-				HSBtoRGB(hue, 100, 100, &red, &green, &blue, 12);
+				HSBtoRGB12(hue, 100, 100, &red, &green, &blue);
 				
 				offsetPixelIndex = pixel - offset;
 				if (offsetPixelIndex < 0) offsetPixelIndex += NUM_OF_PIXELS;
@@ -351,4 +745,27 @@ void tlc5947testRGBWlines()
 	updateOutputs();
 }
 
-/* Interrupt Service Routines ------------------------------------------------*/
\ No newline at end of file
+/* Interrupt Service Routines ------------------------------------------------*/
+#ifdef TLC5947_DOUBLE_BUFFER
+/**
+ * @brief	Sends the next byte of the front buffer and latches the frame when
+ *			the last byte is done
+ */
+ISR(SPI_STC_vect)
+{
+	const uint8_t* pointer = _tlc5947TxPointer;
+	if (pointer != _tlc5947TxEnd)
+	{
+		SPDR = *pointer;
+		_tlc5947TxPointer = pointer + 1;
+	}
+	else
+	{
+		OUTPUT_OFF;
+		LATCH_HIGH;
+		LATCH_LOW;
+		OUTPUT_ON;
+		_tlc5947Busy = 0;
+	}
+}
+#endif
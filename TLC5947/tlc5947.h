@@ -32,6 +32,37 @@
 #define NUM_OF_MODULES	1
 #endif
 
+/*
+ * Minimum time in ms between two latches from tlc5947update(), set calls in
+ * between are merged into one frame. 0 disables the limit, otherwise
+ * MILLIS_COUNT is used.
+ */
+#ifndef TLC5947_FRAME_TIME
+#define TLC5947_FRAME_TIME	0
+#endif
+
+/*
+ * Define TLC5947_DOUBLE_BUFFER to compose the next frame while the last one
+ * is streamed out by the SPI interrupt, SPI_STC_vect is then used by this
+ * driver. Each byte costs an interrupt so a slower SPI clock leaves more time
+ * for the main loop, at SPI_CLOCK_DIV2 the CPU would spend all its time in
+ * the interrupt. The SPI can then not be used by other drivers, a polled
+ * transfer would never see SPIF since the interrupt clears it.
+ */
+#ifndef TLC5947_SPI_CLOCK
+#ifdef TLC5947_DOUBLE_BUFFER
+#define TLC5947_SPI_CLOCK	SPI_CLOCK_DIV8
+#else
+#define TLC5947_SPI_CLOCK	SPI_CLOCK_DIV2
+#endif
+#endif
+
+/*
+ * Define TLC5947_CORRECTION for an 8-bit correction per output and a global
+ * brightness. They are applied when the values are packed so changing the
+ * brightness only repacks the last frame. Costs 5 bytes of RAM per output.
+ */
+
 #define NUM_OF_PIXELS	16
 #define TOTAL_OF_PIXELS	(NUM_OF_MODULES*NUM_OF_PIXELS)
 
@@ -40,12 +71,22 @@
 /* Function prototypes -------------------------------------------------------*/
 void TLC5947_Init();
 
+void tlc5947update();
+uint8_t tlc5947updatePending();
+uint8_t tlc5947isBusy();
 void tlc5947clearAll();
 void tlc5947setPixelRGB(const uint8_t pixel, const uint8_t module, 
 						const uint16_t red, const uint16_t green, const uint16_t blue);
 void tlc5947setPixelRGBxy(const uint8_t x, const uint8_t y, const uint8_t module, 
 						const uint16_t red, const uint16_t green, const uint16_t blue);
 void tlc5947setAllRGB(const uint16_t red, const uint16_t green, const uint16_t blue);
+void tlc5947setFrame(const uint16_t* rgb, uint16_t count);
+#ifdef TLC5947_CORRECTION
+void tlc5947setBrightness(const uint8_t brightness);
+uint8_t tlc5947getBrightness();
+void tlc5947setCorrection(const uint8_t output, const uint8_t module, const uint8_t correction);
+void tlc5947setModuleCorrection(const uint8_t module, const uint8_t red, const uint8_t green, const uint8_t blue);
+#endif
 
 void tlc5947testAllWhite();
 void tlc5947testHUEAll(const uint16_t delayTime);
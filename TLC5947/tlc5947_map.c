@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @file	tlc5947_map.c
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains functions to address TLC5947 modules tiled into a larger
+ *			matrix with x/y coordinates
+ *			- Panel description in flash, one entry per tile
+ *			- Pixel order in each tile from a table in flash
+ *			- Set a pixel, fill rows, columns and rectangles
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <assert/assert.h>
+#include "tlc5947_map.h"
+
+/* Private defines -----------------------------------------------------------*/
+/*
+ * Pixel number for position (x, y) in a tile. The position is first turned
+ * back to the unrotated tile (U, V) where V is the line and U the position
+ * in the line.
+ */
+#define ROTATE_U(R, X, Y)	((R) == 0 ? (X) : (R) == 1 ? (Y) : (R) == 2 ? 3 - (X) : 3 - (Y))
+#define ROTATE_V(R, X, Y)	((R) == 0 ? (Y) : (R) == 1 ? 3 - (X) : (R) == 2 ? 3 - (Y) : (X))
+#define TILE_PIXEL(S, U, V)	((V) * 4 + (((S) && ((V) & 1)) ? 3 - (U) : (U)))
+
+#define ENTRY(O, I)			TILE_PIXEL((O) >> 2, ROTATE_U((O) & 3, (I) & 3, (I) >> 2), \
+									ROTATE_V((O) & 3, (I) & 3, (I) >> 2)),
+
+#define REPEAT_4(O, I)		ENTRY(O, I) ENTRY(O, (I) + 1) ENTRY(O, (I) + 2) ENTRY(O, (I) + 3)
+#define REPEAT_16(O)		{ REPEAT_4(O, 0) REPEAT_4(O, 4) REPEAT_4(O, 8) REPEAT_4(O, 12) },
+
+/* Private variables ---------------------------------------------------------*/
+// [orientation][y * 4 + x] -> pixel in the module
+static const uint8_t _tlc5947MapOrientation[8][16] PROGMEM = {
+	REPEAT_16(0) REPEAT_16(1) REPEAT_16(2) REPEAT_16(3)
+	REPEAT_16(4) REPEAT_16(5) REPEAT_16(6) REPEAT_16(7)
+};
+
+const TLC5947_MAP_Tile_TypeDef* _tlc5947MapTiles;
+
+/* Private functions ---------------------------------------------------------*/
+static void fillTile(uint8_t TileX, uint8_t TileY, uint8_t X0, uint8_t Y0, uint8_t X1, uint8_t Y1,
+					uint16_t Red, uint16_t Green, uint16_t Blue);
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief	Initializes the mapping with a panel description
+ * @param	Tiles: Pointer to a TLC5947_MAP_Tile_TypeDef[TLC5947_MAP_TILES_Y][TLC5947_MAP_TILES_X]
+ *			array in PROGMEM, row by row from the top left tile. 0 puts the
+ *			modules in chain order from left to right and top to bottom, all
+ *			with TLC5947_MAP_SERPENTINE.
+ * @retval	None
+ */
+void TLC5947_MAP_Init(const TLC5947_MAP_Tile_TypeDef* Tiles)
+{
+	_tlc5947MapTiles = Tiles;
+}
+
+/**
+ * @brief	Sets the color of one pixel
+ * @param	X: Column, 0 to TLC5947_MAP_WIDTH - 1
+ * @param	Y: Row, 0 to TLC5947_MAP_HEIGHT - 1
+ * @param	Red, Green, Blue: 12-bit color values
+ * @retval	None
+ */
+void TLC5947_MAP_SetPixel(uint8_t X, uint8_t Y, uint16_t Red, uint16_t Green, uint16_t Blue)
+{
+	if (X < TLC5947_MAP_WIDTH && Y < TLC5947_MAP_HEIGHT)
+		fillTile(X >> 2, Y >> 2, X & 3, Y & 3, X & 3, Y & 3, Red, Green, Blue);
+}
+
+/**
+ * @brief	Sets the color of all pixels in a rectangle, parts outside the panel
+ *			are skipped
+ * @param	X, Y: Top left pixel of the rectangle
+ * @param	Width, Height: Size of the rectangle in pixels
+ * @param	Red, Green, Blue: 12-bit color values
+ * @retval	None
+ * @note	The tile lookup is done once per tile and not per pixel
+ */
+void TLC5947_MAP_FillRect(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height,
+						uint16_t Red, uint16_t Green, uint16_t Blue)
+{
+	if (X >= TLC5947_MAP_WIDTH || Y >= TLC5947_MAP_HEIGHT || !Width || !Height) return;
+	
+	// Last pixel, inclusive
+	uint16_t xEnd = (uint16_t)X + Width - 1;
+	uint16_t yEnd = (uint16_t)Y + Height - 1;
+	if (xEnd >= TLC5947_MAP_WIDTH) xEnd = TLC5947_MAP_WIDTH - 1;
+	if (yEnd >= TLC5947_MAP_HEIGHT) yEnd = TLC5947_MAP_HEIGHT - 1;
+	
+	for (uint8_t tileY = Y >> 2; tileY <= (yEnd >> 2); tileY++)
+	{
+		uint8_t y0 = (tileY == (Y >> 2)) ? (Y & 3) : 0;
+		uint8_t y1 = (tileY == (yEnd >> 2)) ? (yEnd & 3) : 3;
+		for (uint8_t tileX = X >> 2; tileX <= (xEnd >> 2); tileX++)
+		{
+			uint8_t x0 = (tileX == (X >> 2)) ? (X & 3) : 0;
+			uint8_t x1 = (tileX == (xEnd >> 2)) ? (xEnd & 3) : 3;
+			fillTile(tileX, tileY, x0, y0, x1, y1, Red, Green, Blue);
+		}
+	}
+}
+
+/**
+ * @brief	Sets the color of a whole row
+ * @param	Y: The row
+ * @param	Red, Green, Blue: 12-bit color values
+ * @retval	None
+ */
+void TLC5947_MAP_FillRow(uint8_t Y, uint16_t Red, uint16_t Green, uint16_t Blue)
+{
+	TLC5947_MAP_FillRect(0, Y, TLC5947_MAP_WIDTH, 1, Red, Green, Blue);
+}
+
+/**
+ * @brief	Sets the color of a whole column
+ * @param	X: The column
+ * @param	Red, Green, Blue: 12-bit color values
+ * @retval	None
+ */
+void TLC5947_MAP_FillColumn(uint8_t X, uint16_t Red, uint16_t Green, uint16_t Blue)
+{
+	TLC5947_MAP_FillRect(X, 0, 1, TLC5947_MAP_HEIGHT, Red, Green, Blue);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Sets the color of a rectangle inside one tile
+ * @param	TileX, TileY: The tile
+ * @param	X0, Y0: Top left pixel in the tile, 0-3
+ * @param	X1, Y1: Bottom right pixel in the tile, 0-3, inclusive
+ * @param	Red, Green, Blue: 12-bit color values
+ * @retval	None
+ */
+static void fillTile(uint8_t TileX, uint8_t TileY, uint8_t X0, uint8_t Y0, uint8_t X1, uint8_t Y1,
+					uint16_t Red, uint16_t Green, uint16_t Blue)
+{
+	uint8_t module, orientation;
+	if (_tlc5947MapTiles)
+	{
+		const TLC5947_MAP_Tile_TypeDef* tile = &_tlc5947MapTiles[TileY * TLC5947_MAP_TILES_X + TileX];
+		module = pgm_read_byte(&tile->module);
+		orientation = pgm_read_byte(&tile->orientation);
+		assert_param(module < NUM_OF_MODULES && IS_TLC5947_MAP_ORIENTATION(orientation));
+	}
+	else
+	{
+		module = TileY * TLC5947_MAP_TILES_X + TileX;
+		orientation = TLC5947_MAP_SERPENTINE;
+	}
+	
+	const uint8_t* pixels = _tlc5947MapOrientation[orientation];
+	for (uint8_t y = Y0; y <= Y1; y++)
+	{
+		for (uint8_t x = X0; x <= X1; x++)
+			tlc5947setPixelRGB(pgm_read_byte(&pixels[y * 4 + x]), module, Red, Green, Blue);
+	}
+}
@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @file	tlc5947_map.h
+ * @author	Hampus Sandberg
+ * @version	0.1
+ * @date	2026-10-19
+ * @brief	Contains typedefs and function prototypes to address TLC5947
+ *			modules tiled into a larger matrix with x/y coordinates
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TLC5947_MAP_H_
+#define TLC5947_MAP_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "tlc5947.h"
+
+/* Defines -------------------------------------------------------------------*/
+/*
+ * Every module is a 4x4 tile. The panel is TLC5947_MAP_TILES_X tiles wide and
+ * TLC5947_MAP_TILES_Y tiles high, x = 0, y = 0 is the top left pixel.
+ */
+#ifndef TLC5947_MAP_TILES_X
+#define TLC5947_MAP_TILES_X		NUM_OF_MODULES
+#endif
+#ifndef TLC5947_MAP_TILES_Y
+#define TLC5947_MAP_TILES_Y		1
+#endif
+
+#if TLC5947_MAP_TILES_X * TLC5947_MAP_TILES_Y > NUM_OF_MODULES
+#error "The TLC5947 panel has more tiles than NUM_OF_MODULES"
+#endif
+
+#define TLC5947_MAP_TILE_SIZE	4
+#define TLC5947_MAP_WIDTH		(TLC5947_MAP_TILES_X * TLC5947_MAP_TILE_SIZE)
+#define TLC5947_MAP_HEIGHT		(TLC5947_MAP_TILES_Y * TLC5947_MAP_TILE_SIZE)
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief	How the 16 pixels of a module are wired in the tile. Lines are the
+ *			rows of the tile. PROGRESSIVE lines all start at the left edge,
+ *			SERPENTINE lines change direction every line. The rotation turns
+ *			the wiring clockwise.
+ */
+typedef enum
+{
+	TLC5947_MAP_PROGRESSIVE =		0x00,
+	TLC5947_MAP_PROGRESSIVE_90 =	0x01,
+	TLC5947_MAP_PROGRESSIVE_180 =	0x02,
+	TLC5947_MAP_PROGRESSIVE_270 =	0x03,
+	TLC5947_MAP_SERPENTINE =		0x04,
+	TLC5947_MAP_SERPENTINE_90 =		0x05,
+	TLC5947_MAP_SERPENTINE_180 =	0x06,
+	TLC5947_MAP_SERPENTINE_270 =	0x07
+} TLC5947_MAP_Orientation_TypeDef;
+#define IS_TLC5947_MAP_ORIENTATION(ORIENTATION) ((ORIENTATION) <= TLC5947_MAP_SERPENTINE_270)
+
+/**
+ * @brief	One tile of the panel description
+ */
+typedef struct
+{
+	uint8_t module;			/** Module in the chain, 0 is the first module */
+	uint8_t orientation;	/** Wiring of the pixels in the tile
+								This parameter can be any value of TLC5947_MAP_Orientation_TypeDef */
+} TLC5947_MAP_Tile_TypeDef;
+
+/* Function prototypes -------------------------------------------------------*/
+void TLC5947_MAP_Init(const TLC5947_MAP_Tile_TypeDef* Tiles);
+void TLC5947_MAP_SetPixel(uint8_t X, uint8_t Y, uint16_t Red, uint16_t Green, uint16_t Blue);
+void TLC5947_MAP_FillRect(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height,
+						uint16_t Red, uint16_t Green, uint16_t Blue);
+void TLC5947_MAP_FillRow(uint8_t Y, uint16_t Red, uint16_t Green, uint16_t Blue);
+void TLC5947_MAP_FillColumn(uint8_t X, uint16_t Red, uint16_t Green, uint16_t Blue);
+
+#endif /* TLC5947_MAP_H_ */
@@ -2,35 +2,480 @@
  ******************************************************************************
  * @file	timer.c
  * @author	Hampus Sandberg
- * @version	0.1
+ * @version	0.2
  * @date	2013-02-14
  * @brief	Contains functions to manage the TIMER-peripheral on ATmega328x
- *			- Initialization
+ *			- Initialization of mode, prescaler, compare values and outputs
+ *			- Overflow and compare match callbacks
+ *			- Input capture on ICP1 into a ring buffer
+ * @note	The ISRs in this file are weak. A module that defines its own ISR
+ *			for a vector (like MILLIS_COUNT for TIMER1_COMPA_vect) replaces the
+ *			one here, and callbacks for that event will not be called.
  ******************************************************************************
  */
 
 /* Includes ------------------------------------------------------------------*/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <assert/assert.h>
 #include "timer.h"
 
 /* Private defines -----------------------------------------------------------*/
+#define CLOCK_SELECT_MASK	((1 << CS02) | (1 << CS01) | (1 << CS00))
+#define CLOCK_INVALID		0xFF
+
+#define COMPARE_OUTPUT_A_SHIFT	6
+#define COMPARE_OUTPUT_B_SHIFT	4
+
+#define CAPTURE_MASK		(TIMER_CAPTURE_BUFFER_SIZE - 1)
+
 /* Private variables ---------------------------------------------------------*/
+// The register layout of TCCRxA, TCCRxB and TIMSKx is the same on all timers
+static volatile uint8_t* const _timerTccrA[] = {&TCCR0A, &TCCR1A, &TCCR2A};
+static volatile uint8_t* const _timerTccrB[] = {&TCCR0B, &TCCR1B, &TCCR2B};
+static volatile uint8_t* const _timerTimsk[] = {&TIMSK0, &TIMSK1, &TIMSK2};
+
+// WGM1 bits for the modes that are common to all timers
+static const uint8_t _timer1Waveform[] = {0x00, 0x01, 0x04, 0x05, 0x00, 0x0B, 0x00, 0x0F};
+
+// CSx bits for each TIMER_Prescaler_TypeDef
+static const uint8_t _timerClockSelect[] = {0, 1, 2, CLOCK_INVALID, 3, CLOCK_INVALID, 4, 5, 6, 7};
+static const uint8_t _timer2ClockSelect[] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+TIMER_Callback_TypeDef _timerCallbacks[3][3];
+
+volatile uint16_t _timerCaptureBuffer[TIMER_CAPTURE_BUFFER_SIZE];
+volatile uint8_t _timerCaptureIn;
+volatile uint8_t _timerCaptureOut;
+volatile uint8_t _timerCaptureOverruns;
+uint8_t _timerCaptureBothEdges;
+
 /* Private functions ---------------------------------------------------------*/
+static uint8_t getClockSelect(TIMER_TypeDef TIMERx, TIMER_Prescaler_TypeDef Prescaler);
+static void setOutputPinAsOutput(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel);
 
 /* Functions -----------------------------------------------------------------*/
 /**
- * @brief	Initializes the UART peripheral according to the specified parameters in the UART_InitStruct.
- * @param	UART_InitStruct: pointer to a UART_Init_TypeDef structure that contains
- *			the configuration information for the UART peripheral.
+ * @brief	Initializes the TIMER peripheral according to the specified parameters in the TIMER_InitStruct.
+ *			The timer is stopped while it is configured, the counter is cleared
+ *			and then it is started with the given prescaler.
+ * @param	TIMERx: The timer to initialize
+ * @param	TIMER_InitStruct: pointer to a TIMER_Init_TypeDef structure that contains
+ *			the configuration information for the TIMER peripheral.
  * @retval	None
  */
 void TIMER_Init(TIMER_TypeDef TIMERx, TIMER_Init_TypeDef *TIMER_InitStruct)
 {
 	// Check parameters
 	assert_param(IS_TIMER(TIMERx));
-	assert_param(IS_TIMER_MODE(TIMER_InitStruct->mode));
+	assert_param(IS_TIMER_MODE(TIMER_InitStruct->mode) || 
+				(TIMERx == TIMER_1 && IS_TIMER1_MODE(TIMER_InitStruct->mode)));
+	assert_param(IS_TIMER_PRESCALER(TIMERx, TIMER_InitStruct->prescaler));
+	assert_param(IS_TIMER_OUTPUT(TIMER_InitStruct->outputA));
+	assert_param(IS_TIMER_OUTPUT(TIMER_InitStruct->outputB));
+	
+	uint8_t waveform = TIMER_InitStruct->mode;
+	if (TIMERx == TIMER_1 && IS_TIMER_MODE(TIMER_InitStruct->mode))
+		waveform = _timer1Waveform[TIMER_InitStruct->mode];
+	waveform &= 0x0F;
+	
+	uint8_t compareOutput = (TIMER_InitStruct->outputA << COMPARE_OUTPUT_A_SHIFT) | 
+							(TIMER_InitStruct->outputB << COMPARE_OUTPUT_B_SHIFT);
+	uint8_t clockSelect = getClockSelect(TIMERx, TIMER_InitStruct->prescaler);
+	
+	switch (TIMERx)
+	{
+	case TIMER_0:
+		TCCR0B = 0;
+		TCCR0A = compareOutput | (waveform & 0x03);
+		TCNT0 = 0;
+		OCR0A = TIMER_InitStruct->compareA;
+		OCR0B = TIMER_InitStruct->compareB;
+		TCCR0B = ((waveform & 0x04) << (WGM02 - 2)) | clockSelect;
+		break;
+	case TIMER_1:
+		// Keep the input capture settings. ICR1 can only be written when the
+		// mode uses it as TOP, so the mode is set before it with the clock stopped.
+		TCCR1B = (TCCR1B & ((1 << ICNC1) | (1 << ICES1))) | ((waveform & 0x0C) << (WGM12 - 2));
+		TCCR1A = compareOutput | (waveform & 0x03);
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			ICR1 = TIMER_InitStruct->top;
+			OCR1A = TIMER_InitStruct->compareA;
+			OCR1B = TIMER_InitStruct->compareB;
+			TCNT1 = 0;
+		}
+		TCCR1B |= clockSelect;
+		break;
+	case TIMER_2:
+		TCCR2B = 0;
+		TCCR2A = compareOutput | (waveform & 0x03);
+		TCNT2 = 0;
+		OCR2A = TIMER_InitStruct->compareA;
+		OCR2B = TIMER_InitStruct->compareB;
+		TCCR2B = ((waveform & 0x04) << (WGM22 - 2)) | clockSelect;
+		break;
+	}
+	
+	if (TIMER_InitStruct->outputA != TIMER_OUTPUT_DISCONNECTED)
+		setOutputPinAsOutput(TIMERx, TIMER_CHANNEL_A);
+	if (TIMER_InitStruct->outputB != TIMER_OUTPUT_DISCONNECTED)
+		setOutputPinAsOutput(TIMERx, TIMER_CHANNEL_B);
+}
+
+/**
+ * @brief	Starts a timer or changes its prescaler
+ * @param	TIMERx: The timer to start
+ * @param	Prescaler: The clock source to use
+ * @retval	None
+ */
+void TIMER_Start(TIMER_TypeDef TIMERx, TIMER_Prescaler_TypeDef Prescaler)
+{
+	assert_param(IS_TIMER(TIMERx));
+	assert_param(IS_TIMER_PRESCALER(TIMERx, Prescaler));
+	
+	volatile uint8_t* tccrB = _timerTccrB[TIMERx];
+	*tccrB = (*tccrB & ~CLOCK_SELECT_MASK) | getClockSelect(TIMERx, Prescaler);
 }
 
-/* Interrupt Service Routines ------------------------------------------------*/
\ No newline at end of file
+/**
+ * @brief	Stops a timer by removing its clock source
+ * @param	TIMERx: The timer to stop
+ * @retval	None
+ */
+void TIMER_Stop(TIMER_TypeDef TIMERx)
+{
+	assert_param(IS_TIMER(TIMERx));
+	*_timerTccrB[TIMERx] &= ~CLOCK_SELECT_MASK;
+}
+
+/**
+ * @brief	Checks if a timer is running
+ * @param	TIMERx: The timer to check
+ * @retval	1: The timer has a clock source
+ * @retval	0: The timer is stopped
+ */
+uint8_t TIMER_IsRunning(TIMER_TypeDef TIMERx)
+{
+	assert_param(IS_TIMER(TIMERx));
+	return (*_timerTccrB[TIMERx] & CLOCK_SELECT_MASK) != 0;
+}
+
+/**
+ * @brief	Sets the compare value for a channel
+ * @param	TIMERx: The timer to use
+ * @param	Channel: The channel to set
+ * @param	Value: The new compare value, only 8 bits are used on TIMER_0 and TIMER_2
+ * @retval	None
+ * @note	In PWM modes the new value is double buffered by the hardware
+ */
+void TIMER_SetCompare(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel, uint16_t Value)
+{
+	assert_param(IS_TIMER(TIMERx));
+	assert_param(IS_TIMER_CHANNEL(Channel));
+	
+	switch (TIMERx)
+	{
+	case TIMER_0:
+		if (Channel == TIMER_CHANNEL_A) OCR0A = Value;
+		else OCR0B = Value;
+		break;
+	case TIMER_1:
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			if (Channel == TIMER_CHANNEL_A) OCR1A = Value;
+			else OCR1B = Value;
+		}
+		break;
+	case TIMER_2:
+		if (Channel == TIMER_CHANNEL_A) OCR2A = Value;
+		else OCR2B = Value;
+		break;
+	}
+}
+
+/**
+ * @brief	Sets the compare output mode for a channel
+ * @param	TIMERx: The timer to use
+ * @param	Channel: The channel to set
+ * @param	Output: The new output mode, TIMER_OUTPUT_DISCONNECTED gives the pin back to the PORT register
+ * @retval	None
+ */
+void TIMER_SetOutput(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel, TIMER_Output_TypeDef Output)
+{
+	assert_param(IS_TIMER(TIMERx));
+	assert_param(IS_TIMER_CHANNEL(Channel));
+	assert_param(IS_TIMER_OUTPUT(Output));
+	
+	uint8_t shift = (Channel == TIMER_CHANNEL_A) ? COMPARE_OUTPUT_A_SHIFT : COMPARE_OUTPUT_B_SHIFT;
+	volatile uint8_t* tccrA = _timerTccrA[TIMERx];
+	*tccrA = (*tccrA & ~(0x03 << shift)) | (Output << shift);
+	
+	if (Output != TIMER_OUTPUT_DISCONNECTED)
+		setOutputPinAsOutput(TIMERx, Channel);
+}
+
+/**
+ * @brief	Checks if the compare output for a channel is connected to its pin
+ * @param	TIMERx: The timer to check
+ * @param	Channel: The channel to check
+ * @retval	1: Connected
+ * @retval	0: Disconnected
+ */
+uint8_t TIMER_OutputIsConnected(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel)
+{
+	assert_param(IS_TIMER(TIMERx));
+	assert_param(IS_TIMER_CHANNEL(Channel));
+	
+	uint8_t shift = (Channel == TIMER_CHANNEL_A) ? COMPARE_OUTPUT_A_SHIFT : COMPARE_OUTPUT_B_SHIFT;
+	return (*_timerTccrA[TIMERx] & (0x03 << shift)) != 0;
+}
+
+/**
+ * @brief	Reads the counter value
+ * @param	TIMERx: The timer to read
+ * @retval	The counter value
+ */
+uint16_t TIMER_GetCounter(TIMER_TypeDef TIMERx)
+{
+	assert_param(IS_TIMER(TIMERx));
+	
+	uint16_t counter = 0;
+	switch (TIMERx)
+	{
+	case TIMER_0:
+		counter = TCNT0;
+		break;
+	case TIMER_1:
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			counter = TCNT1;
+		}
+		break;
+	case TIMER_2:
+		counter = TCNT2;
+		break;
+	}
+	return counter;
+}
+
+/**
+ * @brief	Writes the counter value
+ * @param	TIMERx: The timer to write
+ * @param	Value: The new counter value
+ * @retval	None
+ */
+void TIMER_SetCounter(TIMER_TypeDef TIMERx, uint16_t Value)
+{
+	assert_param(IS_TIMER(TIMERx));
+	
+	switch (TIMERx)
+	{
+	case TIMER_0:
+		TCNT0 = Value;
+		break;
+	case TIMER_1:
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			TCNT1 = Value;
+		}
+		break;
+	case TIMER_2:
+		TCNT2 = Value;
+		break;
+	}
+}
+
+/**
+ * @brief	Sets the function to call when an event happens and enables the interrupt for it
+ * @param	TIMERx: The timer to use
+ * @param	Event: The event to set the callback for
+ * @param	Callback: The function to call from the ISR, 0 will disable the interrupt
+ * @retval	None
+ */
+void TIMER_SetCallback(TIMER_TypeDef TIMERx, TIMER_Event_TypeDef Event, TIMER_Callback_TypeDef Callback)
+{
+	assert_param(IS_TIMER(TIMERx));
+	assert_param(IS_TIMER_EVENT(Event));
+	
+	// TOIEx, OCIExA and OCIExB are bit 0, 1 and 2 in all TIMSKx registers
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_timerCallbacks[TIMERx][Event] = Callback;
+		if (Callback)
+			*_timerTimsk[TIMERx] |= (1 << Event);
+		else
+			*_timerTimsk[TIMERx] &= ~(1 << Event);
+	}
+	sei();
+}
+
+/**
+ * @brief	Starts input capture on ICP1 (PB0). Captured TIMER1 values are put
+ *			in a ring buffer that is read with TIMER_InputCaptureRead.
+ * @param	Edge: Edge that triggers a capture, TIMER_CAPTURE_BOTH switches edge after every capture
+ * @param	NoiseCanceler: 1 to enable the noise canceler (adds 4 clock cycles of delay)
+ * @retval	None
+ * @note	TIMER_1 must be running. The captured values are raw counter values
+ *			so the mode and prescaler of TIMER_1 decide what they mean.
+ */
+void TIMER_InputCaptureInit(TIMER_CaptureEdge_TypeDef Edge, uint8_t NoiseCanceler)
+{
+	assert_param(IS_TIMER_CAPTURE_EDGE(Edge));
+	
+	DDRB &= ~(1 << PORTB0);
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_timerCaptureIn = 0;
+		_timerCaptureOut = 0;
+		_timerCaptureOverruns = 0;
+		_timerCaptureBothEdges = (Edge == TIMER_CAPTURE_BOTH);
+		
+		uint8_t tccrB = TCCR1B & ~((1 << ICNC1) | (1 << ICES1));
+		if (NoiseCanceler) tccrB |= (1 << ICNC1);
+		// With both edges the first capture is on the edge away from the current level
+		if (Edge == TIMER_CAPTURE_RISING || (Edge == TIMER_CAPTURE_BOTH && !(PINB & (1 << PINB0))))
+			tccrB |= (1 << ICES1);
+		TCCR1B = tccrB;
+		
+		// Changing the edge can set the flag
+		TIFR1 = (1 << ICF1);
+		TIMSK1 |= (1 << ICIE1);
+	}
+	sei();
+}
+
+/**
+ * @brief	Stops input capture on ICP1
+ * @param	None
+ * @retval	None
+ */
+void TIMER_InputCaptureDeInit()
+{
+	TIMSK1 &= ~(1 << ICIE1);
+}
+
+/**
+ * @brief	Gets the number of captured values in the ring buffer
+ * @param	None
+ * @retval	Number of values that can be read
+ */
+uint8_t TIMER_InputCaptureAvailable()
+{
+	return (_timerCaptureIn - _timerCaptureOut) & CAPTURE_MASK;
+}
+
+/**
+ * @brief	Reads the oldest captured value from the ring buffer
+ * @param	None
+ * @retval	The ICR1 value at the capture, 0 if the buffer is empty
+ */
+uint16_t TIMER_InputCaptureRead()
+{
+	uint8_t out = _timerCaptureOut;
+	if (out == _timerCaptureIn) return 0;
+	
+	uint16_t value = _timerCaptureBuffer[out];
+	_timerCaptureOut = (out + 1) & CAPTURE_MASK;
+	return value;
+}
+
+/**
+ * @brief	Gets the number of captures that were lost because the buffer was full
+ * @param	None
+ * @retval	The number of lost captures, saturates at 255
+ */
+uint8_t TIMER_InputCaptureOverruns()
+{
+	return _timerCaptureOverruns;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief	Translates a prescaler to the CSx bits for a timer
+ * @param	TIMERx: The timer to use
+ * @param	Prescaler: The prescaler to translate
+ * @retval	The CSx bits
+ */
+static uint8_t getClockSelect(TIMER_TypeDef TIMERx, TIMER_Prescaler_TypeDef Prescaler)
+{
+	uint8_t clockSelect;
+	if (TIMERx == TIMER_2)
+		clockSelect = _timer2ClockSelect[Prescaler];
+	else
+		clockSelect = _timerClockSelect[Prescaler];
+	assert_param(clockSelect != CLOCK_INVALID);
+	return clockSelect;
+}
+
+/**
+ * @brief	Sets the OCxA/OCxB pin for a channel as output
+ * @param	TIMERx: The timer to use
+ * @param	Channel: The channel to use
+ * @retval	None
+ */
+static void setOutputPinAsOutput(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel)
+{
+	switch (TIMERx)
+	{
+	case TIMER_0:
+		// OC0A = PD6, OC0B = PD5
+		DDRD |= (Channel == TIMER_CHANNEL_A) ? (1 << PORTD6) : (1 << PORTD5);
+		break;
+	case TIMER_1:
+		// OC1A = PB1, OC1B = PB2
+		DDRB |= (Channel == TIMER_CHANNEL_A) ? (1 << PORTB1) : (1 << PORTB2);
+		break;
+	case TIMER_2:
+		// OC2A = PB3, OC2B = PD3
+		if (Channel == TIMER_CHANNEL_A) DDRB |= (1 << PORTB3);
+		else DDRD |= (1 << PORTD3);
+		break;
+	}
+}
+
+/* Interrupt Service Routines ------------------------------------------------*/
+#define TIMER_CALLBACK_ISR(VECTOR, TIMERx, EVENT)		\
+	ISR(VECTOR, __attribute__((weak)))					\
+	{													\
+		if (_timerCallbacks[TIMERx][EVENT])				\
+			_timerCallbacks[TIMERx][EVENT]();			\
+	}
+
+TIMER_CALLBACK_ISR(TIMER0_OVF_vect, TIMER_0, TIMER_EVENT_OVERFLOW)
+TIMER_CALLBACK_ISR(TIMER0_COMPA_vect, TIMER_0, TIMER_EVENT_COMPARE_A)
+TIMER_CALLBACK_ISR(TIMER0_COMPB_vect, TIMER_0, TIMER_EVENT_COMPARE_B)
+TIMER_CALLBACK_ISR(TIMER1_OVF_vect, TIMER_1, TIMER_EVENT_OVERFLOW)
+TIMER_CALLBACK_ISR(TIMER1_COMPA_vect, TIMER_1, TIMER_EVENT_COMPARE_A)
+TIMER_CALLBACK_ISR(TIMER1_COMPB_vect, TIMER_1, TIMER_EVENT_COMPARE_B)
+TIMER_CALLBACK_ISR(TIMER2_OVF_vect, TIMER_2, TIMER_EVENT_OVERFLOW)
+TIMER_CALLBACK_ISR(TIMER2_COMPA_vect, TIMER_2, TIMER_EVENT_COMPARE_A)
+TIMER_CALLBACK_ISR(TIMER2_COMPB_vect, TIMER_2, TIMER_EVENT_COMPARE_B)
+
+/**
+ * @brief	Puts the captured value in the ring buffer
+ */
+ISR(TIMER1_CAPT_vect, __attribute__((weak)))
+{
+	uint16_t capture = ICR1;
+	
+	if (_timerCaptureBothEdges)
+	{
+		TCCR1B ^= (1 << ICES1);
+		TIFR1 = (1 << ICF1);
+	}
+	
+	uint8_t in = _timerCaptureIn;
+	uint8_t next = (in + 1) & CAPTURE_MASK;
+	if (next != _timerCaptureOut)
+	{
+		_timerCaptureBuffer[in] = capture;
+		_timerCaptureIn = next;
+	}
+	else if (_timerCaptureOverruns != 0xFF)
+	{
+		_timerCaptureOverruns++;
+	}
+}
@@ -2,7 +2,7 @@
  ******************************************************************************
  * @file	timer.h
  * @author	Hampus Sandberg
- * @version	0.1
+ * @version	0.2
  * @date	2013-02-14
  * @brief	Contains function prototypes, constants to manage the Timer-peripheral
  *			on ATmega328x
@@ -15,6 +15,22 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Defines -------------------------------------------------------------------*/
+/*
+ * Ownership registry. A module that takes over the counter, mode and prescaler
+ * of a timer puts TIMER_CLAIM(TIMER_x) in its .c-file. If two modules in the
+ * same project claim the same timer the link fails with
+ * "multiple definition of `_timerOwner_TIMER_x'".
+ */
+#define TIMER_CLAIM(TIMERx)	const uint8_t _timerOwner_##TIMERx = 1
+
+#ifndef TIMER_CAPTURE_BUFFER_SIZE
+#define TIMER_CAPTURE_BUFFER_SIZE	16
+#endif
+
+#if (TIMER_CAPTURE_BUFFER_SIZE & (TIMER_CAPTURE_BUFFER_SIZE - 1)) != 0 || TIMER_CAPTURE_BUFFER_SIZE > 128
+#error "TIMER_CAPTURE_BUFFER_SIZE must be a power of 2 and at most 128"
+#endif
+
 /* Typedefs ------------------------------------------------------------------*/
 /**
  * @brief	Timer peripheral
@@ -29,7 +45,10 @@ typedef enum
 #define IS_TIMER(TIMER) (((TIMER) == TIMER_0) || ((TIMER) == TIMER_1) || ((TIMER) == TIMER_2))
 
 /**
- * @brief  Timer Init structure definition
+ * @brief	Timer mode
+ * @note	The first modes can be used on all timers. On TIMER_1 the 0xFF TOP
+ *			modes are the 8-bit modes and CTC uses OCR1A as TOP. The TIMER1_
+ *			modes can only be used on TIMER_1.
  */
 typedef enum
 {
@@ -38,23 +57,137 @@ typedef enum
 	TIMER_CTC_MODE =						0x02,
 	TIMER_FAST_PWM_0xFF_TOP_MODE =			0x03,
 	TIMER_PWM_PHASE_CORRECT_OCRA_TOP_MODE =	0x05,
-	TIMER_FAST_PWM_OCRA_TOP_MODE =			0x07
+	TIMER_FAST_PWM_OCRA_TOP_MODE =			0x07,
 	
+	TIMER1_PWM_PHASE_CORRECT_9BIT_MODE =	0x12,
+	TIMER1_PWM_PHASE_CORRECT_10BIT_MODE =	0x13,
+	TIMER1_FAST_PWM_9BIT_MODE =				0x16,
+	TIMER1_FAST_PWM_10BIT_MODE =			0x17,
+	TIMER1_PWM_PHASE_FREQ_CORRECT_ICR_TOP_MODE =	0x18,
+	TIMER1_PWM_PHASE_FREQ_CORRECT_OCRA_TOP_MODE =	0x19,
+	TIMER1_PWM_PHASE_CORRECT_ICR_TOP_MODE =	0x1A,
+	TIMER1_CTC_ICR_TOP_MODE =				0x1C,
+	TIMER1_FAST_PWM_ICR_TOP_MODE =			0x1E
 } TIMER_Mode_TypeDef;
 #define IS_TIMER_MODE(MODE) (((MODE) == TIMER_NORMAL_MODE) || ((MODE) == TIMER_PWM_PHASE_CORRECT_0xFF_TOP_MODE) || \
 							((MODE) == TIMER_CTC_MODE) || ((MODE) == TIMER_FAST_PWM_0xFF_TOP_MODE) || \
 							((MODE) == TIMER_PWM_PHASE_CORRECT_OCRA_TOP_MODE) || ((MODE) == TIMER_FAST_PWM_OCRA_TOP_MODE))
+#define IS_TIMER1_MODE(MODE) (((MODE) == TIMER1_PWM_PHASE_CORRECT_9BIT_MODE) || ((MODE) == TIMER1_PWM_PHASE_CORRECT_10BIT_MODE) || \
+							((MODE) == TIMER1_FAST_PWM_9BIT_MODE) || ((MODE) == TIMER1_FAST_PWM_10BIT_MODE) || \
+							((MODE) == TIMER1_PWM_PHASE_FREQ_CORRECT_ICR_TOP_MODE) || \
+							((MODE) == TIMER1_PWM_PHASE_FREQ_CORRECT_OCRA_TOP_MODE) || \
+							((MODE) == TIMER1_PWM_PHASE_CORRECT_ICR_TOP_MODE) || ((MODE) == TIMER1_CTC_ICR_TOP_MODE) || \
+							((MODE) == TIMER1_FAST_PWM_ICR_TOP_MODE))
+
+/**
+ * @brief	Timer clock source
+ * @note	TIMER_PRESCALER_32 and TIMER_PRESCALER_128 only exist on TIMER_2,
+ *			the external clock only on TIMER_0 (T0) and TIMER_1 (T1)
+ */
+typedef enum
+{
+	TIMER_PRESCALER_STOPPED =	0x00,
+	TIMER_PRESCALER_1 =			0x01,
+	TIMER_PRESCALER_8 =			0x02,
+	TIMER_PRESCALER_32 =		0x03,
+	TIMER_PRESCALER_64 =		0x04,
+	TIMER_PRESCALER_128 =		0x05,
+	TIMER_PRESCALER_256 =		0x06,
+	TIMER_PRESCALER_1024 =		0x07,
+	TIMER_EXTERNAL_FALLING =	0x08,
+	TIMER_EXTERNAL_RISING =		0x09
+} TIMER_Prescaler_TypeDef;
+#define IS_TIMER_PRESCALER(TIMER, PRESCALER) ((TIMER) == TIMER_2 ? ((PRESCALER) <= TIMER_PRESCALER_1024) : \
+											((PRESCALER) <= TIMER_EXTERNAL_RISING && (PRESCALER) != TIMER_PRESCALER_32 && \
+											(PRESCALER) != TIMER_PRESCALER_128))
+
+/**
+ * @brief	Compare output mode for the OCxA/OCxB pins
+ * @note	In PWM modes TIMER_OUTPUT_CLEAR is non-inverting and TIMER_OUTPUT_SET
+ *			is inverting PWM
+ */
+typedef enum
+{
+	TIMER_OUTPUT_DISCONNECTED =	0x00,
+	TIMER_OUTPUT_TOGGLE =		0x01,
+	TIMER_OUTPUT_CLEAR =		0x02,
+	TIMER_OUTPUT_SET =			0x03
+} TIMER_Output_TypeDef;
+#define IS_TIMER_OUTPUT(OUTPUT) ((OUTPUT) <= TIMER_OUTPUT_SET)
+
+/**
+ * @brief	Compare output channel
+ */
+typedef enum
+{
+	TIMER_CHANNEL_A =	0x00,
+	TIMER_CHANNEL_B =	0x01
+} TIMER_Channel_TypeDef;
+#define IS_TIMER_CHANNEL(CHANNEL) (((CHANNEL) == TIMER_CHANNEL_A) || ((CHANNEL) == TIMER_CHANNEL_B))
+
+/**
+ * @brief	Timer events that can have a callback
+ */
+typedef enum
+{
+	TIMER_EVENT_OVERFLOW =	0x00,
+	TIMER_EVENT_COMPARE_A =	0x01,
+	TIMER_EVENT_COMPARE_B =	0x02
+} TIMER_Event_TypeDef;
+#define IS_TIMER_EVENT(EVENT) ((EVENT) <= TIMER_EVENT_COMPARE_B)
+
+/**
+ * @brief	Edge that triggers an input capture on ICP1
+ */
+typedef enum
+{
+	TIMER_CAPTURE_FALLING =	0x00,
+	TIMER_CAPTURE_RISING =	0x01,
+	TIMER_CAPTURE_BOTH =	0x02
+} TIMER_CaptureEdge_TypeDef;
+#define IS_TIMER_CAPTURE_EDGE(EDGE) ((EDGE) <= TIMER_CAPTURE_BOTH)
+
+/**
+ * @brief	Typedef for a pointer to a function that is called from a timer interrupt
+ */
+typedef void (*TIMER_Callback_TypeDef)(void);
 
 /**
  * @brief  Timer Init structure definition
  */
 typedef struct
 {
-	TIMER_Mode_TypeDef mode;	/** Specifies which mode the timer should be used in
-									This parameter can be any value of TIMER_Mode_TypeDef */
+	TIMER_Mode_TypeDef mode;				/** Specifies which mode the timer should be used in
+												This parameter can be any value of TIMER_Mode_TypeDef */
+	TIMER_Prescaler_TypeDef prescaler;		/** Specifies the clock source for the timer
+												This parameter can be any value of TIMER_Prescaler_TypeDef */
+	TIMER_Output_TypeDef outputA;			/** Specifies the behaviour of the OCxA pin
+												This parameter can be any value of TIMER_Output_TypeDef */
+	TIMER_Output_TypeDef outputB;			/** Specifies the behaviour of the OCxB pin
+												This parameter can be any value of TIMER_Output_TypeDef */
+	uint16_t compareA;						/** Value for OCRxA, only 8 bits are used on TIMER_0 and TIMER_2 */
+	uint16_t compareB;						/** Value for OCRxB, only 8 bits are used on TIMER_0 and TIMER_2 */
+	uint16_t top;							/** Value for ICR1 in the ICR TOP modes, only used on TIMER_1 */
 } TIMER_Init_TypeDef;
 
 /* Function prototypes -------------------------------------------------------*/
 void TIMER_Init(TIMER_TypeDef TIMERx, TIMER_Init_TypeDef *TIMER_InitStruct);
+void TIMER_Start(TIMER_TypeDef TIMERx, TIMER_Prescaler_TypeDef Prescaler);
+void TIMER_Stop(TIMER_TypeDef TIMERx);
+uint8_t TIMER_IsRunning(TIMER_TypeDef TIMERx);
+
+void TIMER_SetCompare(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel, uint16_t Value);
+void TIMER_SetOutput(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel, TIMER_Output_TypeDef Output);
+uint8_t TIMER_OutputIsConnected(TIMER_TypeDef TIMERx, TIMER_Channel_TypeDef Channel);
+uint16_t TIMER_GetCounter(TIMER_TypeDef TIMERx);
+void TIMER_SetCounter(TIMER_TypeDef TIMERx, uint16_t Value);
+
+void TIMER_SetCallback(TIMER_TypeDef TIMERx, TIMER_Event_TypeDef Event, TIMER_Callback_TypeDef Callback);
+
+void TIMER_InputCaptureInit(TIMER_CaptureEdge_TypeDef Edge, uint8_t NoiseCanceler);
+void TIMER_InputCaptureDeInit();
+uint8_t TIMER_InputCaptureAvailable();
+uint16_t TIMER_InputCaptureRead();
+uint8_t TIMER_InputCaptureOverruns();
 
-#endif /* TIMER_H_ */
\ No newline at end of file
+#endif /* TIMER_H_ */
@@ -44,6 +44,10 @@
 #define GET_RGB_LED_PIXEL			0x0017
 #define SET_RGB_LED_PIXEL			0x0018
 
+#define WRITE_ANIMATION				0x0019
+#define START_ANIMATION				0x001A
+#define STOP_ANIMATION				0x001B
+
 
 
 #endif /* HOME_AUTOMATION_COMMANDS_H_ */
\ No newline at end of file